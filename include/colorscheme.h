@@ -0,0 +1,74 @@
+// File: colorscheme.h
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QTimer>
+#include <QDBusVariant>
+
+class QAction;
+class SharedIcon;
+class StatusNotifierItem;
+
+/**
+ * ColorSchemeWatcher
+ * ------------------
+ * • Follows org.freedesktop.appearance / color-scheme through the settings
+ *   portal (SNI_SETTINGS_PORTAL_SERVICE overrides the service name, e.g. a
+ *   local stand-in for tests) unless a scheme is forced with setForced().
+ * • The initial value is read asynchronously: items start light and switch
+ *   once the portal answers, without ever blocking the Qt thread.
+ * • Trays and menu items register a light and a dark SharedIcon; both are
+ *   already marshalled, so a scheme change is a pointer swap per item, with
+ *   one coalesced update (one NewIcon) per tray.
+ * • Lives in the Qt thread.
+ */
+class ColorSchemeWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    static ColorSchemeWatcher *instance();
+
+    /** Drops the registration of `sni` / `action`, if the watcher exists */
+    static void forget(StatusNotifierItem *sni);
+    static void forget(QAction *action);
+
+    bool isDark() const;
+
+    /** -1 follows the portal, 0 forces light, 1 forces dark */
+    void setForced(int scheme);
+
+    /** Takes a reference on both icons; applies the current variant now */
+    void setThemedIcon(StatusNotifierItem *sni, SharedIcon *light, SharedIcon *dark);
+    void setThemedIcon(QAction *action, SharedIcon *light, SharedIcon *dark);
+
+private Q_SLOTS:
+    void onSettingChanged(const QString &ns, const QString &key, const QDBusVariant &value);
+    void applyAll();
+
+private:
+    explicit ColorSchemeWatcher(QObject *parent = nullptr);
+    ~ColorSchemeWatcher() override;
+
+    struct Variants
+    {
+        SharedIcon *light = nullptr;
+        SharedIcon *dark  = nullptr;
+    };
+
+    void readInitial(const QString &method);
+    void schemeChanged(bool dark);
+    static void apply(StatusNotifierItem *sni, const Variants &v, bool dark);
+    static void apply(QAction *action, const Variants &v, bool dark);
+    static void release(Variants &v);
+
+    QString mService;
+    bool    mPortalDark = false;
+    bool    mPortalKnown = false;      // réponse ou signal du portail reçu
+    int     mForced     = -1;
+    bool    mAppliedDark = false;
+    QTimer  mApplyTimer;
+
+    QHash<StatusNotifierItem*, Variants> mTrays;
+    QHash<QAction*, Variants>            mActions;
+};
@@ -0,0 +1,133 @@
+// File: iconcache.h
+#pragma once
+
+#include <QAtomicInt>
+#include <QCache>
+#include <QIcon>
+#include <QString>
+
+#include "dbustypes.h"
+
+class QImage;
+class SharedIcon;
+
+/** Marshalled icon plus a stable key used by setters to skip duplicates */
+struct CachedIcon
+{
+    qint64         key = 0;
+    IconPixmapList pixmaps;
+
+    bool isNull() const { return pixmaps.isEmpty(); }
+};
+
+/**
+ * IconCache
+ * ---------
+ * • Process-wide cache of icons already converted to IconPixmapList, keyed
+ *   by file path and revalidated against the file's size and mtime.
+ * • The pixmap bytes are implicitly shared: handing a cached icon to a tray
+ *   is a pointer copy, not a new decode.
+ * • Keys are negative so they never collide with QIcon::cacheKey().
+ * • Only used from the Qt thread.
+ */
+class IconCache
+{
+public:
+    static IconCache &instance();
+
+    /**
+     * Decoded icon for `path`, from the cache when the file is unchanged.
+     * PNG files are decoded by PngDecoder straight to the wire format,
+     * SVG files are rasterized by SvgRasterizer at standardSizes();
+     * other formats go through QIcon.
+     */
+    CachedIcon fromFile(const QString &path);
+
+    /**
+     * Icon decoded from encoded bytes (PNG, SVG, …) through QImageReader,
+     * cached by content hash. Returns a new reference, or nullptr if the
+     * data cannot be decoded.
+     */
+    SharedIcon *fromEncoded(const QByteArray &data, const QByteArray &formatHint);
+
+    /** Drops the entry for `path` (next fromFile() decodes again) */
+    void invalidate(const QString &path);
+
+    /** Sizes rendered for scalable sources and generated for large bitmaps */
+    static const QList<int> &standardSizes();
+
+    /**
+     * `native` plus every standard size smaller than it, all produced by
+     * IconScaler from this single source; a native side above 256 is
+     * dropped in favour of the generated sizes.
+     */
+    static IconPixmapList withStandardSizes(const IconPixmap &native);
+
+    /** Allocates a new key for an icon built outside the cache */
+    static qint64 nextKey();
+
+private:
+    IconCache();
+
+    struct FileEntry
+    {
+        qint64     mtime = 0;
+        qint64     size  = 0;
+        CachedIcon icon;
+    };
+
+    struct EncodedEntry
+    {
+        explicit EncodedEntry(SharedIcon *icon);
+        ~EncodedEntry();
+        SharedIcon *icon;
+    };
+
+    QCache<QString, FileEntry>       mFiles;
+    QCache<QByteArray, EncodedEntry> mEncoded;
+};
+
+/**
+ * SharedIcon
+ * ----------
+ * • Ref-counted icon handle exposed by the C API (create_icon & co).
+ * • Resolved and decoded once; trays receive its marshalled pixmaps and
+ *   menu items its QIcon, both implicitly shared, so attaching it anywhere
+ *   is a pointer copy and the handle may be released right after.
+ * • Created and consumed on the Qt thread; ref()/deref() are thread-safe.
+ */
+class SharedIcon
+{
+public:
+    /** Theme name, or file path when such a file exists */
+    static SharedIcon *fromPathOrName(const QString &pathOrName);
+
+    static SharedIcon *fromImage(const QImage &image);
+
+    /** Already-marshalled pixmaps; the QIcon is only built if a menu asks */
+    static SharedIcon *fromPixmaps(const CachedIcon &pixmaps);
+
+    /**
+     * Native-endian 0xAARRGGBB pixels (QImage::Format_ARGB32 layout);
+     * nullptr unless both sides are in 1..kMaxArgbSide
+     */
+    static SharedIcon *fromArgb(const quint32 *argb, int width, int height);
+    static constexpr int kMaxArgbSide = 4096;
+
+    void ref();
+    void deref();                       // deletes the handle on last release
+
+    /** Non-empty when the icon should be sent by name (theme icon) */
+    QString themeName() const { return mThemeName; }
+
+    const QIcon &icon() const;
+    const CachedIcon &pixmaps() const { return mPixmaps; }
+
+private:
+    SharedIcon() = default;
+
+    QAtomicInt mRefs { 1 };
+    QString    mThemeName;
+    mutable QIcon mIcon;
+    CachedIcon    mPixmaps;
+};
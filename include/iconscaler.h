@@ -0,0 +1,42 @@
+// File: iconscaler.h
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * IconScaler
+ * ----------
+ * • Produces every tray size (48, 32, 24, 22, 16, …) from one decoded
+ *   source: the source is converted once to linear-light premultiplied
+ *   floats, then each size is an exact area-average (box filter with
+ *   fractional coverage), so edges and alpha blend like Qt's smooth scaling
+ *   but without gamma darkening.
+ * • Input and output are big-endian straight-alpha ARGB (IconPixmap wire
+ *   format): the byte swap is fused into the final store.
+ * • Inner loops work on 4-float vectors (GCC/Clang vector extensions →
+ *   SSE/AVX on x86, NEON on ARM), with a plain scalar fallback.
+ * • Never upscales; aspect ratio is preserved. Qt-independent, reentrant.
+ */
+class IconScaler
+{
+public:
+    struct Level
+    {
+        int width  = 0;
+        int height = 0;
+        std::vector<uint8_t> argb;      // width * height * 4, A R G B
+    };
+
+    IconScaler(const uint8_t *argb, int width, int height);
+
+    /** Source scaled so its larger side is `side` (source size if smaller) */
+    Level scaled(int side) const;
+
+private:
+    struct Lin4 { float v[4]; };        // premultiplied linear A R G B
+
+    int mWidth;
+    int mHeight;
+    std::vector<Lin4> mLinear;
+};
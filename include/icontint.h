@@ -0,0 +1,34 @@
+// File: icontint.h
+#pragma once
+
+#include <QCache>
+#include <QPair>
+
+#include "iconcache.h"
+
+/**
+ * IconTint
+ * --------
+ * • Recolours symbolic (monochrome) icons: every pixel takes the tint's RGB
+ *   and keeps the source alpha scaled by the tint's alpha.
+ * • The kernel works on the marshalled pixmaps directly, four pixels per
+ *   vector operation, and results are cached per (source key, colour): a
+ *   theme colour change costs microseconds and a known one costs nothing.
+ * • Only used from the Qt thread.
+ */
+class IconTint
+{
+public:
+    static IconTint &instance();
+
+    /** `source` recoloured with 0xAARRGGBB `argb` (new key per result) */
+    CachedIcon apply(const CachedIcon &source, quint32 argb);
+
+    /** Same recolouring without the cache, for frames shown only once */
+    static IconPixmapList recolour(const IconPixmapList &source, quint32 argb);
+
+private:
+    IconTint();
+
+    QCache<QPair<qint64, quint32>, CachedIcon> mCache;
+};
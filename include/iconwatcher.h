@@ -0,0 +1,60 @@
+// File: iconwatcher.h
+#pragma once
+
+#include <QObject>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+
+class StatusNotifierItem;
+
+/**
+ * IconFileWatcher
+ * ---------------
+ * • One QFileSystemWatcher shared by every tray whose icon was set with
+ *   set_icon_by_path_watched().
+ * • Change notifications are debounced; a file is only re-decoded when its
+ *   content really changed (mtime/size first, then content hash), and
+ *   NewIcon is emitted only in that case.
+ * • Survives editors/generators that replace the file atomically (rename):
+ *   the parent directory is watched too and the file is re-armed.
+ * • Lives in the Qt thread.
+ */
+class IconFileWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    static IconFileWatcher *instance();
+
+    /** Stops watching for `sni`, without creating the watcher if unused */
+    static void forget(StatusNotifierItem *sni);
+
+    /** Applies `path` to `sni` now and again whenever its content changes */
+    void watch(StatusNotifierItem *sni, const QString &path);
+    void unwatch(StatusNotifierItem *sni);
+
+private Q_SLOTS:
+    void onFileChanged(const QString &path);
+    void onDirectoryChanged(const QString &dir);
+    void reloadPending();
+
+private:
+    explicit IconFileWatcher(QObject *parent = nullptr);
+
+    struct Stamp
+    {
+        qint64     mtime = -1;
+        qint64     size  = -1;
+        QByteArray hash;
+    };
+
+    bool contentChanged(const QString &path);
+    void apply(const QString &path);
+
+    QFileSystemWatcher                mWatcher;
+    QTimer                            mDebounce;
+    QSet<QString>                     mPending;
+    QHash<StatusNotifierItem*, QString> mPathOf;
+    QHash<QString, Stamp>             mStamps;
+};
@@ -0,0 +1,43 @@
+// File: livebinding.h
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+
+class StatusNotifierItem;
+struct sni_live_block;
+
+/**
+ * TrayLiveBinding
+ * ---------------
+ * • Samples an application-owned sni_live_block at a fixed rate, so a
+ *   telemetry producer only does a few stores per update and never calls
+ *   into the library.
+ * • Reads use the block's seqlock: retry while a write is in progress or
+ *   the sequence moved during the copy; a tick is skipped rather than
+ *   waiting on a busy writer.
+ * • Each tick feeds the graph sample (time-based, every tick); value and
+ *   tooltip are only re-applied when the sequence changed.
+ * • A child of its StatusNotifierItem, lives in the Qt thread. The block
+ *   must outlive the binding.
+ */
+class TrayLiveBinding : public QObject
+{
+    Q_OBJECT
+public:
+    /** Binds `block` to `sni` (replacing any binding); nullptr unbinds */
+    static void bind(StatusNotifierItem *sni, const sni_live_block *block, int hz);
+
+private Q_SLOTS:
+    void sample();
+
+private:
+    TrayLiveBinding(StatusNotifierItem *sni, const sni_live_block *block, int hz);
+
+    bool snapshot(sni_live_block &out) const;
+
+    StatusNotifierItem *mSni;
+    const sni_live_block *mBlock;
+    unsigned int mLastSeq;
+    QTimer mTimer;
+};
@@ -0,0 +1,55 @@
+// File: pngdecoder.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * PngDecoder
+ * ----------
+ * • Minimal PNG decoder (zlib inflate + unfiltering) writing straight-alpha
+ *   ARGB in big-endian byte order, i.e. the IconPixmap wire format, at the
+ *   image's native size.
+ * • No QImage / QPixmap / QIcon involved: no QPA pixmap, no premultiply or
+ *   format conversion pass, no separate byte swap.
+ * • Interlaced images, unusual headers and images larger than kMaxSide are
+ *   rejected (decode() returns false): callers fall back to the Qt path.
+ * • Qt-independent and reentrant.
+ */
+class PngDecoder
+{
+public:
+    static constexpr int kMaxSide = 4096;
+
+    PngDecoder(const uint8_t *data, size_t size);
+
+    /** Parses the signature and IHDR; true when decode() can be attempted */
+    bool readHeader();
+
+    int width() const  { return mWidth; }
+    int height() const { return mHeight; }
+
+    /** Decodes into `out` (width() * height() * 4 bytes, A R G B per pixel) */
+    bool decode(uint8_t *out);
+
+    /** True when `data` starts with the PNG signature */
+    static bool isPng(const uint8_t *data, size_t size);
+
+private:
+    bool inflateImage(uint8_t *raw, size_t rawSize);
+    bool unfilter(uint8_t *raw, size_t stride, int bpp) const;
+    void expandRow(const uint8_t *row, uint8_t *out) const;
+
+    const uint8_t *mData;
+    size_t         mSize;
+
+    int mWidth     = 0;
+    int mHeight    = 0;
+    int mBitDepth  = 0;
+    int mColorType = 0;
+
+    uint8_t mPalette[256][4] = {};      // A R G B
+    int     mPaletteSize     = 0;
+    bool    mHasKey          = false;   // tRNS colour key (gray / RGB)
+    uint16_t mKey[3]         = {};
+};
@@ -0,0 +1,48 @@
+// File: privateicontheme.h
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QSize>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+
+/**
+ * PrivateIconTheme
+ * ----------------
+ * • Per-process icon theme (hicolor layout) created lazily under
+ *   $XDG_RUNTIME_DIR, advertised to hosts through IconThemePath.
+ * • Holds the animations referenced by AttentionMovieName so that hosts
+ *   animate them on their side, without any per-frame D-Bus traffic.
+ * • Only used from the Qt thread.
+ */
+class PrivateIconTheme
+{
+public:
+    static PrivateIconTheme &instance();
+
+    /** Theme root to publish as IconThemePath (empty until first install) */
+    QString path() const;
+
+    /**
+     * Movie names become file names: one rejected by isValidName() (path
+     * separator, "..", leading dot) fails the install.
+     */
+    static bool isValidName(const QString &name);
+
+    /** Copies a movie file (gif, mng, …) as animations/<name>.<suffix> */
+    bool installMovie(const QString &name, const QString &file);
+
+    /** Copies a frame set as animations/<name>/0001.png, 0002.png, …; all or nothing */
+    bool installFrames(const QString &name, const QStringList &frames);
+
+private:
+    PrivateIconTheme() = default;
+
+    bool ensureRoot();
+    QString animationsDir(const QSize &size);
+    void writeIndex();
+
+    QScopedPointer<QTemporaryDir> mDir;
+    QStringList mDirectories;
+};
@@ -8,6 +8,9 @@
 #include <QEventLoop>
 #include <functional>
 
+#include <pthread.h>
+#include <sys/types.h>
+
 /**
  * QtThreadManager
  * ---------------
@@ -34,6 +37,114 @@ public:
     /** Accès direct (lecture seule) à la QApplication */
     QApplication* app() const { return m_app; }
 
+    /**
+     * Files de priorité pour le travail différé dans le thread de l’application :
+     * • Interactive : retours utilisateur (clics, molette) ;
+     * • Visible     : changements de propriétés visibles (rechargements d’icônes) ;
+     * • Background  : animations, graphes, échantillonnage.
+     * La vidange suit cet ordre, avec protection contre la famine et un budget
+     * de temps par passage (on rend la main pour laisser passer le D-Bus).
+     */
+    enum class Lane { Interactive = 0, Visible = 1, Background = 2 };
+    static constexpr int LaneCount = 3;
+
+    struct LaneStats
+    {
+        quint64 executed     = 0;
+        quint64 totalDelayNs = 0;     // attente cumulée en file
+        quint64 maxDelayNs   = 0;
+        int     pending      = 0;
+    };
+
+    /**
+     * File bornée : au-delà de la capacité (0 = illimitée), la politique
+     * décide — Block attend une place (jamais depuis le thread Qt),
+     * Drop rejette la nouvelle entrée, Replace évince la plus ancienne
+     * entrée de la file la moins prioritaire. Seules les entrées Property
+     * hors Interactive comptent et subissent la politique : les retours
+     * utilisateur, le travail ordonné et les ticks ne sont jamais perdus.
+     */
+    enum class Overflow { Block = 0, Drop = 1, Replace = 2 };
+
+    struct QueueStats
+    {
+        quint64 coalesced = 0;        // remplacées par une valeur plus récente
+        quint64 dropped   = 0;        // rejetées (Drop)
+        quint64 evicted   = 0;        // évincées (Replace)
+        quint64 blocked   = 0;        // producteurs mis en attente (Block)
+        int     capacity  = 0;
+    };
+
+    /**
+     * Nature d’une entrée :
+     * • Ordered  : FIFO, jamais coalescée ; (owner, key) ne sert qu’à purge() ;
+     * • Tick     : travail interne coalescé (animation, graphe, rechargement),
+     *              hors capacité ;
+     * • Property : mise à jour de propriété coalescée, soumise à la capacité.
+     */
+    enum class Entry { Ordered = 0, Tick = 1, Property = 2 };
+
+    /**
+     * Met `fn` en file dans `lane` (tout thread). Une entrée Tick ou Property
+     * avec un `owner` est coalescée sur (owner, key) : si une entrée identique
+     * attend encore, seule sa fonction est remplacée et elle garde sa place.
+     * Sans owner, l’entrée est toujours Ordered.
+     * Renvoie false si l’entrée a été rejetée.
+     */
+    static bool post(Lane lane, std::function<void()> fn,
+                     const void* owner = nullptr, int key = 0,
+                     Entry entry = Entry::Property);
+
+    /** Retire toutes les entrées en attente de `owner` (avant sa destruction) */
+    static void purge(const void* owner);
+    /** Retire seulement les entrées en attente de (owner, key) */
+    static void purge(const void* owner, int key);
+
+    static void setQueueLimits(int capacity, Overflow policy);
+
+    /** Copie des statistiques par file ; `reset` remet les compteurs à zéro */
+    static void laneStats(LaneStats out[LaneCount], bool reset);
+    static QueueStats queueStats(bool reset);
+
+    /**
+     * Réglages du thread Qt : appliqués au démarrage du thread (la taille de
+     * pile uniquement à ce moment-là), et immédiatement s’il tourne déjà.
+     * Seuls les champs marqués dans `flags` sont appliqués, et retenus avec
+     * ceux des appels précédents pour les démarrages suivants.
+     */
+    enum ThreadConfigFlag {
+        ConfigNice     = 0x01,
+        ConfigSched    = 0x02,
+        ConfigAffinity = 0x04,
+        ConfigName     = 0x08,
+        ConfigStack    = 0x10
+    };
+
+    struct ThreadConfig
+    {
+        unsigned   flags         = 0;
+        int        nice          = 0;
+        int        schedPolicy   = 0;     // SCHED_OTHER, SCHED_BATCH, SCHED_FIFO, …
+        int        schedPriority = 0;
+        quint64    affinityMask  = 0;     // bit n = CPU n
+        QByteArray name;                  // ≤ 15 octets (limite pthread)
+        uint       stackSize     = 0;
+    };
+
+    struct ThreadUsage
+    {
+        bool    valid               = false;
+        quint64 cpuNs               = 0;
+        quint64 voluntarySwitches   = 0;
+        quint64 involuntarySwitches = 0;
+    };
+
+    /** Renvoie les drapeaux en échec si le thread tourne déjà (0 sinon) */
+    static unsigned setThreadConfig(const ThreadConfig& config);
+
+    /** Temps CPU et changements de contexte du thread Qt courant */
+    static ThreadUsage threadUsage();
+
 protected:
     void run() override;      // point d’entrée du QThread
 
@@ -44,7 +155,15 @@ private:
     /** Initialisation commune (création + attente de QApplication) */
     static QtThreadManager* createAndStart();
 
+    /** Vide les files par priorité, dans la limite du budget */
+    static void drainLanes();
+
+    /** Applique `config` au thread appelant ; renvoie les drapeaux en échec */
+    static unsigned applyThreadConfig(const ThreadConfig& config);
+
     QApplication*  m_app      = nullptr;
+    pthread_t      m_pthread  = 0;
+    pid_t          m_tid      = 0;
     QMutex         readyMutex;
     QWaitCondition readyCond;
 };
@@ -0,0 +1,404 @@
+// File: sni_coro.h
+#pragma once
+
+/**
+ * sni_coro.h — C++20 coroutine layer
+ * ----
+ * • `co_await tray.next_event()` pulls from the tray's native event ring
+ *   (tray_enable_events); `co_await tray.notify(...)` and
+ *   `co_await tray.publish()` complete with the D-Bus reply (notification
+ *   id, registration accepted) instead of firing and forgetting.
+ * • Resumption goes through the tray's executor: anything with
+ *   schedule(std::coroutine_handle<>). InlineExecutor resumes on the Qt
+ *   thread; RunLoop resumes on whichever thread calls run()/run_pending().
+ *   No thread is created.
+ * • Awaiters live in the coroutine frame and are handed to the C API as
+ *   user data: no allocation per event or per reply on this side (RunLoop
+ *   only grows when more coroutines are queued than ever before).
+ * • One next_event() at a time per tray. A coroutine suspended in an
+ *   awaiter may be destroyed on the executor thread before it is resumed:
+ *   the pending wait or reply is cancelled, a callback already running is
+ *   waited for, and a resumption already queued is withdrawn. The last
+ *   step needs an executor with withdraw(std::coroutine_handle<>) (RunLoop
+ *   has one; InlineExecutor never queues); with any other executor,
+ *   destruction is only safe until the event or reply has been delivered.
+ *   Destroying the tray wakes next_event() with an empty (false) event.
+ */
+
+#if !defined(__cpp_impl_coroutine) || !defined(__cpp_concepts)
+#error "sni_coro.h requires C++20 coroutines and concepts"
+#endif
+
+#include "sni_cpp.h"
+
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <vector>
+
+namespace sni {
+
+template <typename E>
+concept Executor = std::copy_constructible<E> && requires(E& e, std::coroutine_handle<> h) { e.schedule(h); };
+
+/** Executor able to take back a handle it has queued but not resumed yet */
+template <typename E>
+concept WithdrawingExecutor = Executor<E> && requires(E& e, std::coroutine_handle<> h) { e.withdraw(h); };
+
+/** Resumes on the Qt thread, inside the event or reply dispatch */
+struct InlineExecutor
+{
+    void schedule(std::coroutine_handle<> h) const { h.resume(); }
+};
+
+/** Resumes on the thread driving run() / run_pending() */
+class RunLoop
+{
+public:
+    class Scheduler
+    {
+    public:
+        explicit Scheduler(RunLoop* loop) noexcept : m_loop(loop) {}
+        void schedule(std::coroutine_handle<> h) const { m_loop->schedule(h); }
+        void withdraw(std::coroutine_handle<> h) const { m_loop->withdraw(h); }
+
+    private:
+        RunLoop* m_loop;
+    };
+
+    explicit RunLoop(std::size_t reserve = 64)
+    {
+        m_queue.reserve(reserve);
+        m_batch.reserve(reserve);
+    }
+
+    RunLoop(const RunLoop&) = delete;
+    RunLoop& operator=(const RunLoop&) = delete;
+
+    Scheduler executor() noexcept { return Scheduler(this); }
+
+    void schedule(std::coroutine_handle<> h)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.push_back(h);
+        }
+        m_cv.notify_one();
+    }
+
+    /** Drops `h` if queued and not resumed yet (executor thread only) */
+    void withdraw(std::coroutine_handle<> h)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::erase(m_queue, h);
+        }
+        // Déjà passé dans le lot en cours : neutralisé sur place
+        for (std::coroutine_handle<>& queued : m_batch) {
+            if (queued == h)
+                queued = std::noop_coroutine();
+        }
+    }
+
+    /** Resumes what is queued now; returns how many */
+    std::size_t run_pending()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_batch.swap(m_queue);      // les deux vecteurs gardent leur capacité
+        }
+        const std::size_t n = m_batch.size();
+        for (std::coroutine_handle<> h : m_batch)
+            h.resume();
+        m_batch.clear();
+        return n;
+    }
+
+    /** Resumes queued coroutines until stop() */
+    void run()
+    {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+                if (m_stop && m_queue.empty()) {
+                    m_stop = false;
+                    return;
+                }
+            }
+            run_pending();
+        }
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<std::coroutine_handle<>> m_queue;
+    std::vector<std::coroutine_handle<>> m_batch;
+    bool m_stop = false;
+};
+
+/** Eager, fire-and-forget coroutine type for event loops */
+struct Detached
+{
+    struct promise_type
+    {
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+enum class EventType {
+    None              = SNI_EVENT_NONE,
+    Activate          = SNI_EVENT_ACTIVATE,
+    SecondaryActivate = SNI_EVENT_SECONDARY_ACTIVATE,
+    Scroll            = SNI_EVENT_SCROLL,
+    ClickGesture      = SNI_EVENT_CLICK_GESTURE,
+    Registered        = SNI_EVENT_REGISTERED,
+    Closed            = SNI_EVENT_CLOSED
+};
+
+/** sni_event plus typed accessors; false once the ring is gone */
+struct Event : sni_event
+{
+    EventType kind() const noexcept { return static_cast<EventType>(type); }
+    Orientation scroll_orientation() const noexcept { return static_cast<Orientation>(orientation); }
+    ClickGesture click_gesture() const noexcept { return static_cast<ClickGesture>(gesture); }
+
+    explicit operator bool() const noexcept { return type != SNI_EVENT_NONE && type != SNI_EVENT_CLOSED; }
+};
+
+namespace detail {
+
+/*
+ * État partagé avec le rappel C (thread Qt) : Armed tant qu'il peut encore
+ * venir, Scheduled une fois la reprise confiée à l'exécuteur, Idle après
+ * await_resume().
+ */
+enum class WaitState { Idle, Armed, Scheduled };
+
+/* Reprise déjà en file : la retirer si l'exécuteur le permet */
+template <Executor E>
+void withdraw(E& ex, std::coroutine_handle<> h)
+{
+    if constexpr (WithdrawingExecutor<E>)
+        ex.withdraw(h);
+}
+
+template <Executor E>
+class EventAwaiter
+{
+public:
+    EventAwaiter(void* tray, E ex) : m_tray(tray), m_ex(std::move(ex)) { std::memset(&m_event, 0, sizeof(m_event)); }
+
+    EventAwaiter(const EventAwaiter&) = delete;
+    EventAwaiter& operator=(const EventAwaiter&) = delete;
+
+    ~EventAwaiter()
+    {
+        if (m_state.load(std::memory_order_acquire) == WaitState::Idle)
+            return;
+        // Annulation refusée : elle a attendu la fin du rappel, la reprise est en file
+        if (!::tray_cancel_event_wait(m_tray, this))
+            withdraw(m_ex, m_handle);
+    }
+
+    bool await_ready() noexcept { return ::tray_poll_event(m_tray, &m_event) == 1; }
+
+    bool await_suspend(std::coroutine_handle<> h) noexcept
+    {
+        m_handle = h;
+        m_state.store(WaitState::Armed, std::memory_order_release);
+        const int r = ::tray_next_event(m_tray, &m_event, &EventAwaiter::ready, this);
+        if (r == 0)
+            return true;        // l'awaiter peut déjà être repris : ne plus y toucher
+        m_state.store(WaitState::Idle, std::memory_order_relaxed);
+        if (r < 0)
+            m_event.type = SNI_EVENT_NONE;
+        return false;
+    }
+
+    Event await_resume() noexcept
+    {
+        m_state.store(WaitState::Idle, std::memory_order_relaxed);
+        Event ev;
+        static_cast<sni_event&>(ev) = m_event;
+        return ev;
+    }
+
+private:
+    static void ready(void* data)
+    {
+        auto* self = static_cast<EventAwaiter*>(data);
+        E ex = self->m_ex;
+        std::coroutine_handle<> h = self->m_handle;
+        self->m_state.store(WaitState::Scheduled, std::memory_order_release);
+        ex.schedule(h);
+    }
+
+    void* m_tray;
+    E m_ex;
+    sni_event m_event;
+    std::coroutine_handle<> m_handle;
+    std::atomic<WaitState> m_state{WaitState::Idle};
+};
+
+/** Completes with the AsyncReplyCallback result */
+template <Executor E>
+class ReplyAwaiter
+{
+public:
+    ReplyAwaiter(const ReplyAwaiter&) = delete;
+    ReplyAwaiter& operator=(const ReplyAwaiter&) = delete;
+
+    ~ReplyAwaiter()
+    {
+        if (m_state.load(std::memory_order_acquire) == WaitState::Idle)
+            return;
+        if (!::sni_cancel_async(this))
+            withdraw(m_ex, m_handle);
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    unsigned int await_resume() noexcept
+    {
+        m_state.store(WaitState::Idle, std::memory_order_relaxed);
+        return m_result;
+    }
+
+protected:
+    explicit ReplyAwaiter(E ex) : m_ex(std::move(ex)) {}
+
+    void prepare(std::coroutine_handle<> h) noexcept
+    {
+        m_handle = h;
+        m_state.store(WaitState::Armed, std::memory_order_release);
+    }
+
+    /** The C call refused the request: resume at once with 0 */
+    bool rejected() noexcept
+    {
+        m_state.store(WaitState::Idle, std::memory_order_relaxed);
+        m_result = 0;
+        return false;
+    }
+
+    void* user_data() noexcept { return this; }
+
+    static void reply(unsigned int result, void* data)
+    {
+        auto* self = static_cast<ReplyAwaiter*>(data);
+        self->m_result = result;
+        E ex = self->m_ex;
+        std::coroutine_handle<> h = self->m_handle;
+        self->m_state.store(WaitState::Scheduled, std::memory_order_release);
+        ex.schedule(h);
+    }
+
+private:
+    E m_ex;
+    std::coroutine_handle<> m_handle;
+    unsigned int m_result = 0;
+    std::atomic<WaitState> m_state{WaitState::Idle};
+};
+
+template <Executor E>
+class NotifyAwaiter : public ReplyAwaiter<E>
+{
+public:
+    NotifyAwaiter(void* tray, std::string_view title, std::string_view message,
+                  const char* icon_name, int seconds, E ex)
+        : ReplyAwaiter<E>(std::move(ex)), m_tray(tray), m_title(title), m_message(message),
+          m_icon(icon_name), m_seconds(seconds) {}
+
+    bool await_suspend(std::coroutine_handle<> h) noexcept
+    {
+        this->prepare(h);
+        // Copiées par l'appel C avant son retour
+        CString title(m_title), message(m_message);
+        if (::show_notification_async(m_tray, title.get(), message.get(), m_icon, m_seconds,
+                                      &ReplyAwaiter<E>::reply, this->user_data()))
+            return true;        // peut déjà être repris : ne plus toucher à *this
+        return this->rejected();
+    }
+
+private:
+    void* m_tray;
+    std::string_view m_title, m_message;
+    const char* m_icon;
+    int m_seconds;
+};
+
+template <Executor E>
+class PublishAwaiter : public ReplyAwaiter<E>
+{
+public:
+    PublishAwaiter(void* tray, E ex) : ReplyAwaiter<E>(std::move(ex)), m_tray(tray) {}
+
+    bool await_suspend(std::coroutine_handle<> h) noexcept
+    {
+        this->prepare(h);
+        if (::tray_publish_async(m_tray, &ReplyAwaiter<E>::reply, this->user_data()))
+            return true;
+        return this->rejected();
+    }
+
+    bool await_resume() noexcept { return ReplyAwaiter<E>::await_resume() != 0; }
+
+private:
+    void* m_tray;
+};
+
+} // namespace detail
+
+/**
+ * Tray whose events and replies are awaited. Created deferred with an event
+ * ring of `ring_capacity` entries; `co_await publish()` exports it. With
+ * `click_gestures`, primary clicks arrive as EventType::ClickGesture.
+ */
+template <Executor E = InlineExecutor>
+class AsyncTray : public Tray
+{
+public:
+    explicit AsyncTray(std::string_view id, E ex = E{}, int ring_capacity = 64, bool click_gestures = false)
+        : Tray(id, deferred), m_ex(std::move(ex))
+    {
+        ::tray_enable_events(handle(), ring_capacity, click_gestures ? SNI_EVENTS_CLICK_GESTURES : 0u);
+    }
+
+    /** Next tray event; an empty (false) Event once the tray is gone */
+    [[nodiscard]] detail::EventAwaiter<E> next_event() { return {handle(), m_ex}; }
+
+    /** Notification id from the server, 0 on failure */
+    [[nodiscard]] detail::NotifyAwaiter<E> notify(std::string_view title, std::string_view message,
+                                                  const char* icon_name = "", int seconds = 5)
+    {
+        return {handle(), title, message, icon_name, seconds, m_ex};
+    }
+
+    /** Publishes (if needed); true once the watcher accepted the item */
+    [[nodiscard]] detail::PublishAwaiter<E> publish() { return {handle(), m_ex}; }
+
+    const E& executor() const noexcept { return m_ex; }
+
+private:
+    E m_ex;
+};
+
+} // namespace sni
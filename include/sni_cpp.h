@@ -0,0 +1,567 @@
+// File: sni_cpp.h
+#pragma once
+
+/**
+ * sni_cpp.h — C++17 layer over the C API
+ * ----
+ * • Header-only: Tray, Menu, MenuItem and Icon are move-aware RAII value
+ *   types over the void* handles of sni_wrapper.h, without pulling in Qt.
+ * • Callbacks take any invocable and store it in place (fixed inline
+ *   buffer, no std::function, no heap allocation); captures that do not fit
+ *   are rejected at compile time. The storage lives in per-tray / per-menu
+ *   state with a stable address, handed to the C API as user data.
+ * • Strings: const char* goes straight through; std::string_view is copied
+ *   once into a stack buffer (heap only beyond 255 bytes) for the NUL.
+ * • Properties are set through tags (`tray.set(sni::title, "…")`): the
+ *   value type is checked at compile time.
+ * • Icons are shared handles (create_icon*), attached with the *_handle
+ *   entry points, so a decoded icon is never re-read.
+ * • Callback storage is freed only once the C API has dropped the calls
+ *   still queued for it (replacing a callback, removing or clearing menu
+ *   items, destroying a tray or menu). Do not replace or destroy a callback
+ *   from inside that same callback.
+ */
+
+#ifndef SNI_WRAPPER_C_API_ONLY
+#define SNI_WRAPPER_C_API_ONLY
+#endif
+#include "sni_wrapper.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sni {
+
+namespace detail {
+
+/* Copie terminée par NUL d’un string_view : sur la pile jusqu’à 255 octets */
+class CString
+{
+public:
+    explicit CString(std::string_view s)
+    {
+        if (s.size() < sizeof(m_buf)) {
+            std::memcpy(m_buf, s.data(), s.size());
+            m_buf[s.size()] = '\0';
+            m_ptr = m_buf;
+        } else {
+            m_heap.assign(s.data(), s.size());
+            m_ptr = m_heap.c_str();
+        }
+    }
+
+    CString(const CString&) = delete;
+    CString& operator=(const CString&) = delete;
+
+    const char* get() const noexcept { return m_ptr; }
+
+private:
+    char        m_buf[256];
+    std::string m_heap;
+    const char* m_ptr;
+};
+
+/* Invocable stocké en place ; ni copiable ni déplaçable (adresse stable) */
+template <typename Sig, std::size_t Capacity = 4 * sizeof(void*)>
+class InplaceFunction;
+
+template <typename R, typename... Args, std::size_t Capacity>
+class InplaceFunction<R(Args...), Capacity>
+{
+public:
+    InplaceFunction() noexcept = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InplaceFunction>>>
+    explicit InplaceFunction(F&& f) { construct(std::forward<F>(f)); }
+
+    InplaceFunction(const InplaceFunction&) = delete;
+    InplaceFunction& operator=(const InplaceFunction&) = delete;
+
+    ~InplaceFunction() { reset(); }
+
+    template <typename F>
+    void emplace(F&& f)
+    {
+        reset();
+        construct(std::forward<F>(f));
+    }
+
+    void reset() noexcept
+    {
+        if (m_destroy)
+            m_destroy(&m_storage);
+        m_invoke = nullptr;
+        m_destroy = nullptr;
+    }
+
+    explicit operator bool() const noexcept { return m_invoke != nullptr; }
+
+    R operator()(Args... args) { return m_invoke(&m_storage, std::forward<Args>(args)...); }
+
+private:
+    template <typename F>
+    void construct(F&& f)
+    {
+        using D = std::decay_t<F>;
+        static_assert(std::is_invocable_r_v<R, D&, Args...>, "callback has the wrong signature");
+        static_assert(sizeof(D) <= Capacity, "callback captures too much: capture a pointer or reference instead");
+        static_assert(alignof(D) <= alignof(std::max_align_t), "callback is over-aligned");
+
+        ::new (static_cast<void*>(&m_storage)) D(std::forward<F>(f));
+        m_invoke = [](void* s, Args... args) -> R {
+            return (*static_cast<D*>(s))(std::forward<Args>(args)...);
+        };
+        m_destroy = [](void* s) noexcept { static_cast<D*>(s)->~D(); };
+    }
+
+    alignas(std::max_align_t) unsigned char m_storage[Capacity];
+    R    (*m_invoke)(void*, Args...) = nullptr;
+    void (*m_destroy)(void*) noexcept = nullptr;
+};
+
+/* Callbacks d’un menu : emplacements à adresse stable, recyclés après remove() */
+struct MenuState
+{
+    using Action = InplaceFunction<void()>;
+
+    std::deque<Action>                     actions;   // emplace_back ne déplace rien
+    std::vector<Action*>                   free;
+    std::vector<std::shared_ptr<MenuState>> submenus;
+
+    Action& acquire()
+    {
+        if (free.empty())
+            return actions.emplace_back();
+        Action* slot = free.back();
+        free.pop_back();
+        return *slot;
+    }
+
+    void recycle(Action* slot)
+    {
+        slot->reset();
+        free.push_back(slot);
+    }
+
+    /* Après clear_menu : plus rien n’est en file pour ces éléments */
+    void reset() noexcept
+    {
+        for (auto& submenu : submenus)
+            submenu->reset();
+        submenus.clear();
+        free.clear();
+        actions.clear();
+    }
+};
+
+} // namespace detail
+
+/* ---------------------- Valeurs typées ---------------------- */
+
+enum class Status { Active, Passive, NeedsAttention };
+
+enum class Orientation { Vertical = 0, Horizontal = 1 };
+
+enum class ClickGesture {
+    Single = SNI_CLICK_SINGLE,
+    Double = SNI_CLICK_DOUBLE,
+    Triple = SNI_CLICK_TRIPLE,
+    Repeat = SNI_CLICK_REPEAT
+};
+
+constexpr const char* to_string(Status status) noexcept
+{
+    switch (status) {
+    case Status::Passive:        return "Passive";
+    case Status::NeedsAttention: return "NeedsAttention";
+    case Status::Active:         break;
+    }
+    return "Active";
+}
+
+/* Étiquettes de propriétés : value_type fixe ce que set() accepte */
+namespace prop {
+
+struct Title           { using value_type = std::string_view;
+                         static void apply(void* h, const char* v) noexcept { ::set_title(h, v); } };
+struct ToolTipTitle    { using value_type = std::string_view;
+                         static void apply(void* h, const char* v) noexcept { ::set_tooltip_title(h, v); } };
+struct ToolTipSubtitle { using value_type = std::string_view;
+                         static void apply(void* h, const char* v) noexcept { ::set_tooltip_subtitle(h, v); } };
+struct IconName        { using value_type = std::string_view;
+                         static void apply(void* h, const char* v) noexcept { ::set_icon_by_name(h, v); } };
+struct IconPath        { using value_type = std::string_view;
+                         static void apply(void* h, const char* v) noexcept { ::set_icon_by_path(h, v); } };
+struct StatusProp      { using value_type = Status;
+                         static void apply(void* h, Status v) noexcept { ::set_status(h, to_string(v)); } };
+struct ItemIsMenu      { using value_type = bool;
+                         static void apply(void* h, bool v) noexcept { ::tray_set_item_is_menu(h, v ? 1 : 0); } };
+struct IconTint        { using value_type = std::uint32_t;
+                         static void apply(void* h, std::uint32_t v) noexcept { ::set_icon_tint(h, v); } };
+
+} // namespace prop
+
+inline constexpr prop::Title           title{};
+inline constexpr prop::ToolTipTitle    tooltip_title{};
+inline constexpr prop::ToolTipSubtitle tooltip_subtitle{};
+inline constexpr prop::IconName        icon_name{};
+inline constexpr prop::IconPath        icon_path{};
+inline constexpr prop::StatusProp      status{};
+inline constexpr prop::ItemIsMenu      item_is_menu{};
+inline constexpr prop::IconTint        icon_tint{};
+
+struct deferred_t { explicit deferred_t() = default; };
+inline constexpr deferred_t deferred{};
+
+/* ---------------------- Icon ---------------------- */
+
+/** Shared, ref-counted icon: copies retain, destruction releases */
+class Icon
+{
+public:
+    Icon() noexcept = default;
+
+    static Icon from_name_or_path(const char* path_or_name) { return Icon(::create_icon(path_or_name)); }
+    static Icon from_name_or_path(std::string_view path_or_name)
+    {
+        detail::CString s(path_or_name);
+        return Icon(::create_icon(s.get()));
+    }
+    /** Native-endian 0xAARRGGBB pixels */
+    static Icon from_argb(const std::uint32_t* argb, int width, int height)
+    {
+        return Icon(::create_icon_argb(argb, width, height));
+    }
+    static Icon from_encoded(const void* data, std::size_t len, const char* format_hint = nullptr)
+    {
+        return Icon(::create_icon_encoded(data, len, format_hint));
+    }
+
+    Icon(const Icon& other) noexcept : m_handle(other.m_handle) { if (m_handle) ::icon_retain(m_handle); }
+    Icon(Icon&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+    Icon& operator=(Icon other) noexcept { std::swap(m_handle, other.m_handle); return *this; }
+    ~Icon() { if (m_handle) ::icon_release(m_handle); }
+
+    explicit operator bool() const noexcept { return m_handle != nullptr; }
+    void* handle() const noexcept { return m_handle; }
+
+private:
+    explicit Icon(void* adopted) noexcept : m_handle(adopted) {}
+
+    void* m_handle = nullptr;
+};
+
+/* ---------------------- Menu ---------------------- */
+
+class MenuItem
+{
+public:
+    MenuItem() noexcept = default;
+    MenuItem(void* menu, void* item) noexcept : m_menu(menu), m_item(item) {}
+    MenuItem(void* menu, void* item, std::weak_ptr<detail::MenuState> state,
+             detail::MenuState::Action* slot) noexcept
+        : m_menu(menu), m_item(item), m_state(std::move(state)), m_slot(slot) {}
+
+    void set_text(const char* text) const { ::set_menu_item_text(m_item, text); }
+    void set_text(std::string_view text) const { detail::CString s(text); ::set_menu_item_text(m_item, s.get()); }
+    void set_enabled(bool enabled) const { ::set_menu_item_enabled(m_item, enabled ? 1 : 0); }
+    void set_icon(const Icon& icon) const { ::set_menu_item_icon_handle(m_item, icon.handle()); }
+    void set_icon(const Icon& light, const Icon& dark) const
+    {
+        ::set_menu_item_icon_themed(m_item, light.handle(), dark.handle());
+    }
+    /** Removes the item and frees its callback */
+    void remove()
+    {
+        ::remove_menu_item(m_menu, m_item);
+        if (auto state = m_state.lock(); state && m_slot)
+            state->recycle(m_slot);
+        m_item = nullptr;
+        m_slot = nullptr;
+    }
+
+    explicit operator bool() const noexcept { return m_item != nullptr; }
+    void* handle() const noexcept { return m_item; }
+
+private:
+    void* m_menu = nullptr;
+    void* m_item = nullptr;
+    std::weak_ptr<detail::MenuState>  m_state;
+    detail::MenuState::Action*        m_slot = nullptr;
+};
+
+/**
+ * Owning menu; submenus returned by add_submenu() are views, destroyed with
+ * their parent, whose callbacks are freed with it (or by its clear()). The
+ * menu must outlive any tray it is attached to.
+ */
+class Menu
+{
+public:
+    using Action = detail::MenuState::Action;
+
+    Menu() : m_state(std::make_shared<State>()), m_handle(::create_menu()), m_owning(true) {}
+
+    Menu(const Menu&) = delete;
+    Menu& operator=(const Menu&) = delete;
+    Menu(Menu&& other) noexcept
+        : m_state(std::move(other.m_state)),
+          m_handle(std::exchange(other.m_handle, nullptr)),
+          m_owning(std::exchange(other.m_owning, false)) {}
+    Menu& operator=(Menu&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            m_state = std::move(other.m_state);
+            m_handle = std::exchange(other.m_handle, nullptr);
+            m_owning = std::exchange(other.m_owning, false);
+        }
+        return *this;
+    }
+    ~Menu() { release(); }
+
+    template <typename F>
+    MenuItem add_action(std::string_view text, F&& fn)
+    {
+        detail::CString s(text);
+        Action* slot = store(std::forward<F>(fn));
+        return adopt(::add_menu_action(m_handle, s.get(), &Menu::trampoline, slot), slot);
+    }
+
+    template <typename F>
+    MenuItem add_checkable(std::string_view text, bool checked, F&& fn)
+    {
+        detail::CString s(text);
+        Action* slot = store(std::forward<F>(fn));
+        return adopt(::add_checkable_menu_action(m_handle, s.get(), checked ? 1 : 0,
+                                                 &Menu::trampoline, slot), slot);
+    }
+
+    MenuItem add_disabled(std::string_view text)
+    {
+        detail::CString s(text);
+        return MenuItem(m_handle, ::add_disabled_menu_action(m_handle, s.get(), nullptr, nullptr));
+    }
+
+    void add_separator() { ::add_menu_separator(m_handle); }
+
+    Menu add_submenu(std::string_view text)
+    {
+        detail::CString s(text);
+        auto state = m_state->submenus.emplace_back(std::make_shared<State>());
+        return Menu(std::move(state), ::create_submenu(m_handle, s.get()));
+    }
+
+    void set_icon(const Icon& icon) const { ::set_submenu_icon_handle(m_handle, icon.handle()); }
+
+    /** Removes every item and frees their callbacks, submenus' included */
+    void clear()
+    {
+        ::clear_menu(m_handle);
+        m_state->reset();
+    }
+
+    void* handle() const noexcept { return m_handle; }
+
+private:
+    using State = detail::MenuState;
+
+    Menu(std::shared_ptr<State> state, void* handle) noexcept
+        : m_state(std::move(state)), m_handle(handle), m_owning(false) {}
+
+    template <typename F>
+    Action* store(F&& fn)
+    {
+        Action& slot = m_state->acquire();
+        slot.emplace(std::forward<F>(fn));
+        return &slot;
+    }
+
+    MenuItem adopt(void* item, Action* slot)
+    {
+        if (!item) {
+            m_state->recycle(slot);
+            return MenuItem();
+        }
+        return MenuItem(m_handle, item, m_state, slot);
+    }
+
+    static void trampoline(void* data) { (*static_cast<Action*>(data))(); }
+
+    void release() noexcept
+    {
+        if (m_owning && m_handle)
+            ::destroy_menu(m_handle);
+        m_handle = nullptr;
+        m_owning = false;
+    }
+
+    std::shared_ptr<State> m_state;
+    void* m_handle = nullptr;
+    bool  m_owning = false;
+};
+
+/* ---------------------- Tray ---------------------- */
+
+class Tray
+{
+public:
+    explicit Tray(const char* id) : m_state(new State), m_handle(::create_tray(id)) {}
+    explicit Tray(std::string_view id) : m_state(new State)
+    {
+        detail::CString s(id);
+        m_handle = ::create_tray(s.get());
+    }
+    /** Configure first, then publish() once */
+    Tray(std::string_view id, deferred_t) : m_state(new State)
+    {
+        detail::CString s(id);
+        m_handle = ::create_tray_deferred(s.get());
+    }
+
+    Tray(const Tray&) = delete;
+    Tray& operator=(const Tray&) = delete;
+    Tray(Tray&& other) noexcept
+        : m_state(std::move(other.m_state)), m_handle(std::exchange(other.m_handle, nullptr)) {}
+    Tray& operator=(Tray&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            m_state = std::move(other.m_state);
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+    ~Tray() { release(); }
+
+    void publish() { ::tray_publish(m_handle); }
+
+    template <typename P>
+    void set(P, typename P::value_type value)
+    {
+        if constexpr (std::is_same_v<typename P::value_type, std::string_view>) {
+            detail::CString s(value);
+            P::apply(m_handle, s.get());
+        } else {
+            P::apply(m_handle, value);
+        }
+    }
+
+    template <typename P, std::enable_if_t<std::is_same_v<typename P::value_type, std::string_view>, int> = 0>
+    void set(P, const char* value) { P::apply(m_handle, value); }
+
+    void set_icon(const Icon& icon) { ::set_icon_handle(m_handle, icon.handle()); }
+    void set_icon(const Icon& light, const Icon& dark) { ::set_icon_themed(m_handle, light.handle(), dark.handle()); }
+    void set_overlay_icon(const Icon& icon) { ::set_overlay_icon_handle(m_handle, icon.handle()); }
+    void clear_overlay_icon() { ::clear_overlay_icon(m_handle); }
+    void set_attention_icon(const Icon& icon) { ::set_attention_icon_handle(m_handle, icon.handle()); }
+    void set_menu(const Menu& menu) { ::set_context_menu(m_handle, menu.handle()); }
+
+    void notify(std::string_view title, std::string_view message,
+                const char* icon_name = "", int seconds = 5)
+    {
+        detail::CString t(title), m(message);
+        ::show_notification(m_handle, t.get(), m.get(), icon_name, seconds);
+    }
+
+    void push_graph_sample(float sample) { ::tray_graph_push(m_handle, sample); }
+    void set_value(double value) { ::tray_set_value(m_handle, value); }
+    void set_scroll_coalescing(int window_ms, int notch) { ::set_scroll_coalescing(m_handle, window_ms, notch); }
+
+    /*
+     * on_*: clearing the C callback first drops the calls still queued for
+     * the previous one (synchronously, on the Qt thread), so its storage can
+     * be reused.
+     */
+
+    /** fn(int x, int y) */
+    template <typename F>
+    void on_activate(F&& fn)
+    {
+        ::set_activate_callback(m_handle, nullptr, nullptr);
+        m_state->activate.emplace(std::forward<F>(fn));
+        ::set_activate_callback(m_handle, &Tray::activateThunk, m_state.get());
+    }
+
+    /** fn(int x, int y) */
+    template <typename F>
+    void on_secondary_activate(F&& fn)
+    {
+        ::set_secondary_activate_callback(m_handle, nullptr, nullptr);
+        m_state->secondary.emplace(std::forward<F>(fn));
+        ::set_secondary_activate_callback(m_handle, &Tray::secondaryThunk, m_state.get());
+    }
+
+    /** fn(int delta, sni::Orientation) */
+    template <typename F>
+    void on_scroll(F&& fn)
+    {
+        ::set_scroll_callback(m_handle, nullptr, nullptr);
+        m_state->scroll.emplace(std::forward<F>(fn));
+        ::set_scroll_callback(m_handle, &Tray::scrollThunk, m_state.get());
+    }
+
+    /** fn(sni::ClickGesture, int clicks, int x, int y); replaces on_activate */
+    template <typename F>
+    void on_click_gesture(F&& fn, int multi_click_ms = 0, int max_clicks = 3)
+    {
+        ::set_click_gesture_callback(m_handle, nullptr, nullptr, 0, 0);
+        m_state->gesture.emplace(std::forward<F>(fn));
+        ::set_click_gesture_callback(m_handle, &Tray::gestureThunk, m_state.get(), multi_click_ms, max_clicks);
+    }
+
+    void* handle() const noexcept { return m_handle; }
+
+private:
+    struct State
+    {
+        detail::InplaceFunction<void(int, int)>                    activate;
+        detail::InplaceFunction<void(int, int)>                    secondary;
+        detail::InplaceFunction<void(int, Orientation)>            scroll;
+        detail::InplaceFunction<void(ClickGesture, int, int, int)> gesture;
+    };
+
+    static void activateThunk(int x, int y, void* data)
+    {
+        auto* st = static_cast<State*>(data);
+        if (st->activate) st->activate(x, y);
+    }
+    static void secondaryThunk(int x, int y, void* data)
+    {
+        auto* st = static_cast<State*>(data);
+        if (st->secondary) st->secondary(x, y);
+    }
+    static void scrollThunk(int delta, int orientation, void* data)
+    {
+        auto* st = static_cast<State*>(data);
+        if (st->scroll) st->scroll(delta, static_cast<Orientation>(orientation));
+    }
+    static void gestureThunk(int gesture, int clicks, int x, int y, void* data)
+    {
+        auto* st = static_cast<State*>(data);
+        if (st->gesture) st->gesture(static_cast<ClickGesture>(gesture), clicks, x, y);
+    }
+
+    void release() noexcept
+    {
+        if (m_handle)
+            ::destroy_handle(m_handle);
+        m_handle = nullptr;
+    }
+
+    // Un seul bloc par icône, à adresse stable, passé en user data au C ;
+    // libéré après destroy_handle(), qui a retiré les appels encore en file
+    std::unique_ptr<State> m_state;
+    void* m_handle = nullptr;
+};
+
+} // namespace sni
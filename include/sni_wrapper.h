@@ -7,7 +7,8 @@
 #define EXPORT
 #endif
 
-#ifdef __cplusplus
+// SNI_WRAPPER_C_API_ONLY: C declarations only, for C++ clients built without Qt
+#if defined(__cplusplus) && !defined(SNI_WRAPPER_C_API_ONLY)
 #include <QObject>
 #include <QApplication>
 
@@ -25,7 +26,7 @@ public:
 
     ~SNIWrapperManager() override;
     void startEventLoop();
-    StatusNotifierItem* createSNI(const char* id);
+    StatusNotifierItem* createSNI(const char* id, bool deferred = false);
     void destroySNI(StatusNotifierItem* sni);
     void processEvents();
 
@@ -34,6 +35,9 @@ private:
 };
 #endif
 
+#include <stddef.h>
+#include <string.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -43,6 +47,8 @@ typedef void (*ActivateCallback)(int x, int y, void* user_data);
 typedef void (*SecondaryActivateCallback)(int x, int y, void* user_data);
 typedef void (*ScrollCallback)(int delta, int orientation, void* user_data); // 0: vertical, 1: horizontal
 typedef void (*ActionCallback)(void* user_data);
+typedef void (*ClickGestureCallback)(int gesture, int clicks, int x, int y, void* user_data); // SNI_CLICK_*
+typedef const char* (*PropertyProviderCallback)(void* user_data); // called on the Qt thread; result is copied
 
 /* System tray initialization and cleanup */
 EXPORT int  init_tray_system(void);
@@ -52,19 +58,189 @@ EXPORT void shutdown_tray_system(void);
 EXPORT void* create_tray(const char* id);
 EXPORT void  destroy_handle(void* handle);
 
+/* Deferred creation: configure the tray, then publish it once so the host's
+ * first fetch already sees the final title, icon and menu. */
+EXPORT void* create_tray_deferred(const char* id);
+EXPORT void  tray_publish(void* handle);
+
 /* Tray property setters */
 EXPORT void set_title(void* handle, const char* title);
 EXPORT void set_status(void* handle, const char* status);
 EXPORT void set_icon_by_name(void* handle, const char* name);
 EXPORT void set_icon_by_path(void* handle, const char* path);
 EXPORT void update_icon_by_path(void* handle, const char* path);
+/* Like set_icon_by_path, then reloads the icon whenever the file's content
+ * changes (debounced, shared watcher); any other icon setter stops watching. */
+EXPORT void set_icon_by_path_watched(void* handle, const char* path);
+/* Recolours the tray icon (symbolic style): source alpha, colour from the
+ * 0xAARRGGBB argb; kept across icon changes, 0 turns tinting off. Icons set
+ * by theme name are drawn by the host and are not tinted. */
+EXPORT void set_icon_tint(void* handle, unsigned int argb);
+EXPORT void set_overlay_icon_by_name(void* handle, const char* name);
+EXPORT void set_overlay_icon_by_path(void* handle, const char* path);   /* served from the icon cache */
+EXPORT void clear_overlay_icon(void* handle);
 EXPORT void set_tooltip_title(void* handle, const char* title);
 EXPORT void set_tooltip_subtitle(void* handle, const char* subTitle);
 
+/* Ref-counted icon handles: decoded once, attached to any number of trays and
+ * menu items with a pointer copy. Attached icons keep their data alive, so a
+ * handle may be released right after use. create_icon_argb takes native-endian
+ * 0xAARRGGBB pixels (e.g. a Java int[] from TYPE_INT_ARGB), at most 4096 per
+ * side; larger sizes return NULL. */
+EXPORT void* create_icon(const char* path_or_name);
+EXPORT void* create_icon_argb(const unsigned int* argb, int width, int height);
+EXPORT void* create_icon_encoded(const void* data, size_t len, const char* format_hint);
+EXPORT void  icon_retain(void* icon);
+EXPORT void  icon_release(void* icon);
+EXPORT void  set_icon_handle(void* handle, void* icon);
+EXPORT void  set_overlay_icon_handle(void* handle, void* icon);
+EXPORT void  set_attention_icon_handle(void* handle, void* icon);
+
+/* Icons from in-memory encoded bytes (PNG, SVG, ...): no temp file round trip.
+ * Decoded results are cached by content hash; format_hint may be NULL.
+ * Buffers over INT_MAX bytes are rejected (create_icon_encoded: NULL). */
+EXPORT void set_icon_encoded(void* handle, const void* data, size_t len, const char* format_hint);
+
+/* Short text as the tray icon ("42°", "3", "OK"), rendered natively at every
+ * standard size from a per-font glyph atlas. font_spec is "Family" or
+ * "Family:bold" (NULL/empty = default font); colours are 0xAARRGGBB and a
+ * zero bg_argb leaves the background transparent. Recent strings are cached,
+ * so re-showing a value costs nothing. */
+EXPORT void set_icon_text(void* handle, const char* text, const char* font_spec,
+                          unsigned int fg_argb, unsigned int bg_argb);
+
+/* Sparkline icon: one column per sample, newest on the right. Pushing is a
+ * short lock from any thread; frames are rendered incrementally and capped at
+ * max_fps. min >= max auto-scales to the visible history; the first push or
+ * configure turns the graph on, any other main-icon setter turns it off. */
+EXPORT void tray_graph_configure(void* handle, float min, float max,
+                                 unsigned int line_argb, unsigned int fill_argb,
+                                 unsigned int bg_argb, int max_fps);
+EXPORT void tray_graph_push(void* handle, float sample);
+
+/* Value-to-icon map: bucket i covers [thresholds[i], thresholds[i+1]) and
+ * shows icons[i] (n ascending thresholds, n icon handles, each retained).
+ * tray_set_value() changes the icon only when the bucket changes; a bucket is
+ * left only once the value is more than hysteresis past its edge. */
+EXPORT void tray_set_value_map(void* handle, const double* thresholds, void* const* icons,
+                               int n, double hysteresis);
+EXPORT void tray_set_value(void* handle, double value);
+
+/* Live values through shared memory: the application writes into the block
+ * at any rate (seqlock: seq is odd while a write is in progress) and the
+ * library samples it hz times per second. Each sample pushes graph_sample to
+ * the tray graph; when seq changed, value goes to the value map and the
+ * strings to the tooltip. Only the fields flagged in `fields` are used.
+ * The block must stay valid until unbound (block = NULL) or the tray dies. */
+#define SNI_LIVE_VALUE            0x1u
+#define SNI_LIVE_GRAPH_SAMPLE     0x2u
+#define SNI_LIVE_TOOLTIP_TITLE    0x4u
+#define SNI_LIVE_TOOLTIP_SUBTITLE 0x8u
+
+struct sni_live_block {
+    unsigned int seq;
+    unsigned int fields;                /* SNI_LIVE_* */
+    double       value;
+    float        graph_sample;
+    char         tooltip_title[128];    /* UTF-8, NUL-terminated */
+    char         tooltip_subtitle[128];
+};
+
+EXPORT void tray_bind_live_values(void* handle, struct sni_live_block* block, int hz);
+
+/* Tray groups: a group-wide setter applies the same change to every member in
+ * one Qt-thread hop. Between tray_group_begin() and tray_group_commit() the
+ * changes are queued and applied together; either way each tray emits each
+ * New* signal at most once per flush. Destroyed trays are skipped. */
+EXPORT void* create_tray_group(void);
+EXPORT void  destroy_tray_group(void* group);
+EXPORT void  tray_group_add(void* group, void* handle);
+EXPORT void  tray_group_remove(void* group, void* handle);
+EXPORT void  tray_group_begin(void* group);
+EXPORT void  tray_group_commit(void* group);
+EXPORT void  tray_group_set_status(void* group, const char* status);
+EXPORT void  tray_group_set_title(void* group, const char* title);
+EXPORT void  tray_group_set_tooltip_title(void* group, const char* title);
+EXPORT void  tray_group_set_icon_by_name(void* group, const char* name);
+EXPORT void  tray_group_set_icon_handle(void* group, void* icon);
+
+#ifdef __GNUC__
+/* Writer side: a few stores per update, no library call */
+static inline void sni_live_write_begin(struct sni_live_block* b) {
+    __atomic_store_n(&b->seq, __atomic_load_n(&b->seq, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void sni_live_write_end(struct sni_live_block* b) {
+    __atomic_store_n(&b->seq, __atomic_load_n(&b->seq, __ATOMIC_RELAXED) + 1, __ATOMIC_RELEASE);
+}
+
+static inline void sni_live_set_value(struct sni_live_block* b, double value) {
+    sni_live_write_begin(b);
+    b->value = value;
+    b->fields |= SNI_LIVE_VALUE;
+    sni_live_write_end(b);
+}
+
+static inline void sni_live_set_graph_sample(struct sni_live_block* b, float sample) {
+    sni_live_write_begin(b);
+    b->graph_sample = sample;
+    b->fields |= SNI_LIVE_GRAPH_SAMPLE;
+    sni_live_write_end(b);
+}
+
+static inline void sni_live_set_tooltip(struct sni_live_block* b, const char* title, const char* subtitle) {
+    sni_live_write_begin(b);
+    if (title) {
+        strncpy(b->tooltip_title, title, sizeof(b->tooltip_title) - 1);
+        b->tooltip_title[sizeof(b->tooltip_title) - 1] = '\0';
+        b->fields |= SNI_LIVE_TOOLTIP_TITLE;
+    }
+    if (subtitle) {
+        strncpy(b->tooltip_subtitle, subtitle, sizeof(b->tooltip_subtitle) - 1);
+        b->tooltip_subtitle[sizeof(b->tooltip_subtitle) - 1] = '\0';
+        b->fields |= SNI_LIVE_TOOLTIP_SUBTITLE;
+    }
+    sni_live_write_end(b);
+}
+#endif
+
+/* Light/dark icon variants: both handles are kept (referenced) and the right
+ * one is applied when the desktop colour scheme changes (settings portal,
+ * org.freedesktop.appearance color-scheme), one update per tray.
+ * sni_set_color_scheme: -1 follow the portal (default), 0 light, 1 dark.
+ * sni_get_color_scheme: 1 when the dark variants are in use. */
+EXPORT void set_icon_themed(void* handle, void* light_icon, void* dark_icon);
+EXPORT void set_menu_item_icon_themed(void* menu_item_handle, void* light_icon, void* dark_icon);
+EXPORT void sni_set_color_scheme(int scheme);
+EXPORT int  sni_get_color_scheme(void);
+
+/* Attention animation (AttentionMovieName): the movie or frames are installed
+ * in a private icon theme so hosts animate them without per-frame traffic.
+ * With native_fallback != 0, frames are cycled locally as the attention icon
+ * when the host ignores AttentionMovieName (anything but Plasma) or the
+ * install failed. Frames are installed all or none. The movie name (tray id,
+ * '-', then the file's base name or `name`) must not hold '/', '\' or "..",
+ * nor start with '.'; such an install fails. Return 0 on success. */
+EXPORT int set_attention_movie_by_path(void* handle, const char* movie_path, int native_fallback);
+EXPORT int set_attention_movie_frames(void* handle, const char* name, const char* const* frame_paths,
+                                      int count, int frame_interval_ms, int native_fallback);
+
+/* Pull-model property providers: the callback is only invoked when the host
+ * reads the property, and its result is cached for ttl_ms. Pass cb = NULL to
+ * go back to the value set with the regular setter. Hosts are only notified
+ * (New* signals) when the value is marked stale with invalidate_property(). */
+#define SNI_PROPERTY_TOOLTIP_TITLE    0
+#define SNI_PROPERTY_TOOLTIP_SUBTITLE 1
+#define SNI_PROPERTY_ICON_PATH        2
+EXPORT void set_property_provider(void* handle, int property, PropertyProviderCallback cb, void* data, int ttl_ms);
+EXPORT void invalidate_property(void* handle, int property);
+
 /* Menu creation and management */
 EXPORT void* create_menu(void);
 EXPORT void  destroy_menu(void* menu_handle);            // NEW helper (optional)
 EXPORT void  set_context_menu(void* handle, void* menu);
+EXPORT void  tray_set_item_is_menu(void* handle, int item_is_menu); /* left click opens the menu on the host side */
 EXPORT void* add_menu_action(void* menu_handle, const char* text, ActionCallback cb, void* data);
 EXPORT void* add_disabled_menu_action(void* menu_handle, const char* text, ActionCallback cb, void* data);
 EXPORT void* add_checkable_menu_action(void* menu_handle, const char* text, int checked, ActionCallback cb, void* data);
@@ -75,20 +251,175 @@ EXPORT void  set_menu_item_enabled(void* menu_item_handle, int enabled);
 EXPORT void  remove_menu_item(void* menu_handle, void* menu_item_handle);
 EXPORT void set_menu_item_icon(void *menu_item_handle,const char *icon_path_or_name);
 EXPORT void set_submenu_icon(void* submenu_handle, const char* icon_path_or_name);
+EXPORT void set_menu_item_icon_encoded(void* menu_item_handle, const void* data, size_t len, const char* format_hint);
+EXPORT void set_menu_item_icon_handle(void* menu_item_handle, void* icon);
+EXPORT void set_submenu_icon_handle(void* submenu_handle, void* icon);
 
-    /* Tray event callbacks */
+/* Tray event callbacks: queued on the Qt thread in trigger order. Setting
+ * a callback (or NULL) drops the calls still queued for the previous one;
+ * destroy_handle, destroy_menu, clear_menu and remove_menu_item drop those
+ * of the tray or items they remove, so `data` may be freed right after. */
 EXPORT void set_activate_callback(void* handle, ActivateCallback cb, void* data);
 EXPORT void set_secondary_activate_callback(void* handle, SecondaryActivateCallback cb, void* data);
 EXPORT void set_scroll_callback(void* handle, ScrollCallback cb, void* data);
+/* Merges host Scroll calls per orientation: at most one callback per window_ms
+ * with the summed delta (e.g. 16 = once per frame); notch > 0 (e.g. 120)
+ * reports whole notches only and carries the rest. 0, 0 = raw (default). */
+EXPORT void set_scroll_coalescing(void* handle, int window_ms, int notch);
+/* Click gestures on primary activation: clicks less than multi_click_ms apart
+ * (<= 0: desktop double-click interval) form one burst, reported once as
+ * single/double/triple; max_clicks (1..3) reports immediately when reached,
+ * and each further click of the burst reports SNI_CLICK_REPEAT. While set,
+ * the activate callback is not called. cb = NULL turns recognition off
+ * unless the event ring asked for it (SNI_EVENTS_CLICK_GESTURES).
+ * The set_*_callback functions only replace the wrapper's own connection:
+ * the event ring keeps receiving every event.
+ * SNI hosts only forward clicks, so press/release (long-press) is not
+ * observable here. */
+#define SNI_CLICK_SINGLE 1
+#define SNI_CLICK_DOUBLE 2
+#define SNI_CLICK_TRIPLE 3
+#define SNI_CLICK_REPEAT 4
+EXPORT void set_click_gesture_callback(void* handle, ClickGestureCallback cb, void* data,
+                                       int multi_click_ms, int max_clicks);
 
 /* Notifications */
 EXPORT void show_notification(void* handle, const char* title, const char* msg, const char* iconName, int secs);
 
+/* Async replies: cb runs once on the Qt thread with the result, keyed by
+ * `data` (one pending call per data pointer). show_notification_async
+ * reports the server's notification id, tray_publish_async 1 when the
+ * watcher accepted the item; 0 means the call failed or the tray was
+ * destroyed. sni_cancel_async(data) drops a pending reply; it returns 1 if
+ * the callback will not run, 0 once a callback already running has returned
+ * (immediately from inside it). Both calls return 0 on a NULL handle. */
+typedef void (*AsyncReplyCallback)(unsigned int result, void* user_data);
+EXPORT int show_notification_async(void* handle, const char* title, const char* msg, const char* iconName,
+                                   int secs, AsyncReplyCallback cb, void* data);
+EXPORT int tray_publish_async(void* handle, AsyncReplyCallback cb, void* data);
+EXPORT int sni_cancel_async(void* data);
+
+/* Event ring: tray events are also recorded, from the Qt thread, into a
+ * fixed ring of `capacity` entries (0 disables it) that any thread can read,
+ * instead of running callbacks there. On overflow the oldest event is lost
+ * and counted in the next event's `dropped`. */
+#define SNI_EVENT_NONE               0
+#define SNI_EVENT_ACTIVATE           1
+#define SNI_EVENT_SECONDARY_ACTIVATE 2
+#define SNI_EVENT_SCROLL             3
+#define SNI_EVENT_CLICK_GESTURE      4
+#define SNI_EVENT_REGISTERED         5   /* (re-)registration answered by the watcher */
+#define SNI_EVENT_CLOSED             6   /* tray destroyed or ring disabled; no more events */
+
+struct sni_event {
+    int          type;          /* SNI_EVENT_* */
+    int          x, y;          /* ACTIVATE, SECONDARY_ACTIVATE, CLICK_GESTURE */
+    int          delta;         /* SCROLL */
+    int          orientation;   /* SCROLL: 0 vertical, 1 horizontal */
+    int          gesture;       /* CLICK_GESTURE: SNI_CLICK_* */
+    int          clicks;        /* CLICK_GESTURE */
+    int          registered;    /* REGISTERED: 1 accepted, 0 failed */
+    unsigned int dropped;       /* events lost to overflow just before this one */
+};
+
+typedef void (*EventReadyCallback)(void* user_data);
+
+/* flags: SNI_EVENTS_CLICK_GESTURES recognises click bursts (as
+ * set_click_gesture_callback, with its timing if one was set) so that the
+ * ring receives SNI_EVENT_CLICK_GESTURE instead of SNI_EVENT_ACTIVATE,
+ * even without a gesture callback. */
+#define SNI_EVENTS_CLICK_GESTURES 0x01u
+EXPORT int tray_enable_events(void* handle, int capacity, unsigned int flags);
+/* Pops the oldest event: 1 if `out` was filled, 0 if the ring is empty */
+EXPORT int tray_poll_event(void* handle, struct sni_event* out);
+/* Like tray_poll_event, but on an empty ring arms a one-shot wait: the next
+ * event is written to `out` and cb(data) runs on the Qt thread. Returns 1
+ * (filled now), 0 (armed) or -1 (no ring, or a wait is already armed). Only
+ * one wait per tray; `out` must stay valid until cb runs or is cancelled. */
+EXPORT int tray_next_event(void* handle, struct sni_event* out, EventReadyCallback cb, void* data);
+/* Disarms the wait armed with `data`; 1 if cb will not run. 0 if it already
+ * ran or is running: the call then returns only once cb has returned (unless
+ * made from cb itself), so `data` may be freed right after. */
+EXPORT int tray_cancel_event_wait(void* handle, void* data);
+
 /* Event loop management */
 EXPORT int  sni_exec(void);
 EXPORT void sni_process_events(void);
 EXPORT void sni_stop_exec(void);
 
+/* Deferred library work runs on the Qt thread in three priority lanes:
+ * interactive (click/scroll/menu callbacks), visible (icon reloads, theme
+ * switches) and background (animation, graphs, live sampling). Lanes drain
+ * in that order, with starvation protection and a per-pass time budget so
+ * host D-Bus requests are never stuck behind a burst. Delays are per lane. */
+#define SNI_LANE_INTERACTIVE 0
+#define SNI_LANE_VISIBLE     1
+#define SNI_LANE_BACKGROUND  2
+#define SNI_LANE_COUNT       3
+
+struct sni_lane_stats {
+    unsigned long long executed;
+    unsigned long long total_delay_ns;  /* time spent queued, summed */
+    unsigned long long max_delay_ns;
+    unsigned int       pending;
+};
+
+struct sni_queue_stats {
+    struct sni_lane_stats lanes[SNI_LANE_COUNT];
+    unsigned long long    coalesced;    /* pending entries replaced by a newer value */
+    unsigned long long    dropped;      /* rejected, SNI_OVERFLOW_DROP */
+    unsigned long long    evicted;      /* oldest entries pushed out, SNI_OVERFLOW_REPLACE */
+    unsigned long long    blocked;      /* producers that waited, SNI_OVERFLOW_BLOCK */
+    unsigned int          capacity;     /* 0 = unbounded */
+    /* Qt thread usage (0 when the thread is not running) */
+    unsigned long long    thread_cpu_ns;
+    unsigned long long    thread_voluntary_switches;
+    unsigned long long    thread_involuntary_switches;
+};
+
+EXPORT void sni_get_queue_stats(struct sni_queue_stats* out, int reset);
+
+/* Bounded queue: beyond `capacity` pending property updates (async setters,
+ * see sni_set_async_setters; 0 = unbounded, the default) a new update blocks
+ * the producer, is dropped, or evicts the oldest pending update of the
+ * lowest-priority lane. Updates keyed by (tray, property) never add up: a
+ * newer value replaces the pending one in place. User callbacks, ordered
+ * work and internal ticks (animations, graphs) are never counted, dropped
+ * or evicted. */
+#define SNI_OVERFLOW_BLOCK   0
+#define SNI_OVERFLOW_DROP    1
+#define SNI_OVERFLOW_REPLACE 2
+EXPORT void sni_set_queue_limits(int capacity, int overflow_policy);
+
+/* Opt-in: set_title, set_status, set_icon_by_name/_by_path/_handle and the
+ * tooltip setters return immediately and are applied latest-wins on the Qt
+ * thread. Menu calls stay blocking and ordered; a blocking icon call made
+ * while an async one is pending may be overtaken by it. Off by default. */
+EXPORT void sni_set_async_setters(int enabled);
+
+/* Qt thread settings, applied when the thread starts (and immediately, except
+ * the stack size, if it already runs). Only fields flagged in `flags` are
+ * used, and they add to those of earlier calls; returns -1 on an invalid
+ * config. nice and SCHED_* changes may need privileges: failures are logged
+ * in debug mode only, and do not change the return value. */
+#define SNI_THREAD_NICE     0x01u
+#define SNI_THREAD_SCHED    0x02u
+#define SNI_THREAD_AFFINITY 0x04u
+#define SNI_THREAD_NAME     0x08u
+#define SNI_THREAD_STACK    0x10u
+
+struct sni_thread_config {
+    unsigned int       flags;           /* SNI_THREAD_* */
+    int                nice;            /* -20 .. 19 */
+    int                sched_policy;    /* SCHED_OTHER, SCHED_BATCH, SCHED_IDLE, SCHED_FIFO, SCHED_RR */
+    int                sched_priority;  /* 1 .. 99 for FIFO/RR, else 0 */
+    unsigned long long affinity_mask;   /* bit n = CPU n (first 64 CPUs) */
+    const char*        name;            /* copied; truncated to 15 bytes */
+    size_t             stack_size;      /* bytes */
+};
+
+EXPORT int sni_set_thread_config(const struct sni_thread_config* config);
+
 /* Manage debug mode  */
 EXPORT void sni_set_debug_mode(int enabled);
 
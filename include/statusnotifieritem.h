@@ -33,11 +33,43 @@
 #include <QIcon>
 #include <QMenu>
 #include <QDBusConnection>
+#include <QElapsedTimer>
+
+#include <functional>
 
 #include "dbustypes.h"
 
 class StatusNotifierItemAdaptor;
 class DBusMenuExporter;
+class QTimer;
+
+/*!
+ * Value fetched on demand from a provider and kept for a short time, so that
+ * a GetAll (or a burst of Get) only calls the provider once.
+ */
+template<typename T>
+struct PulledValue
+{
+    std::function<T()> provider;
+    int ttlMs = 0;
+    mutable T value;
+    mutable QElapsedTimer age;
+
+    explicit operator bool() const
+    { return bool(provider); }
+
+    const T &get() const
+    {
+        if (!age.isValid() || age.hasExpired(ttlMs)) {
+            value = provider();
+            age.start();
+        }
+        return value;
+    }
+
+    void invalidate()
+    { age.invalidate(); }
+};
 
 class StatusNotifierItem : public QObject
 {
@@ -48,6 +80,7 @@ class StatusNotifierItem : public QObject
     Q_PROPERTY(QString Id READ id)
     Q_PROPERTY(QString Status READ status)
     Q_PROPERTY(QDBusObjectPath Menu READ menu)
+    Q_PROPERTY(bool ItemIsMenu READ itemIsMenu)
 
     Q_PROPERTY(QString IconName READ iconName)
     Q_PROPERTY(IconPixmapList IconPixmap READ iconPixmap)
@@ -57,13 +90,38 @@ class StatusNotifierItem : public QObject
 
     Q_PROPERTY(QString AttentionIconName READ attentionIconName)
     Q_PROPERTY(IconPixmapList AttentionIconPixmap READ attentionIconPixmap)
+    Q_PROPERTY(QString AttentionMovieName READ attentionMovieName)
+
+    Q_PROPERTY(QString IconThemePath READ iconThemePath)
 
     Q_PROPERTY(ToolTip ToolTip READ toolTip)
 
 public:
-    StatusNotifierItem(QString id, QObject *parent = nullptr);
+    /*!
+     * \param deferRegistration when true, the object is neither exported on
+     * the bus nor registered with the watcher until publish() is called, so
+     * the host's first fetch sees the final initial state.
+     */
+    StatusNotifierItem(QString id, QObject *parent = nullptr, bool deferRegistration = false);
     ~StatusNotifierItem() override;
 
+    /*!
+     * Exports the item and registers it with the watcher. Called by the
+     * constructor unless registration was deferred; idempotent.
+     */
+    void publish();
+    bool isPublished() const
+    { return mPublished; }
+
+    /*! Outcome of the last RegisterStatusNotifierItem call to the watcher */
+    enum Registration {
+        RegistrationPending,
+        RegistrationFailed,
+        Registered
+    };
+    Registration registration() const
+    { return mRegistration; }
+
     QString id() const
     { return mId; }
 
@@ -83,13 +141,38 @@ public:
     { return mMenuPath; }
     void setMenuPath(const QString &path);
 
+    /*!
+     * When true, hosts open the exported menu on left click instead of
+     * calling Activate (and Activate, if still called, shows the menu).
+     */
+    bool itemIsMenu() const
+    { return mItemIsMenu; }
+    void setItemIsMenu(bool itemIsMenu);
+
+    /*! Empty while an icon provider is set; the pushed name comes back with it */
     QString iconName() const
-    { return mIconName; }
+    { return mIconProvider ? QString() : mIconName; }
     void setIconByName(const QString &name);
 
     IconPixmapList iconPixmap() const
-    { return mIcon; }
+    { return mIconProvider ? mIconProvider.get() : mIcon; }
     void setIconByPixmap(const QIcon &icon);
+    /*! Already-marshalled icon (e.g. from IconCache); \param key identifies it */
+    void setIconByPixmaps(const IconPixmapList &pixmaps, qint64 key);
+    /*!
+     * Next frame of a live icon (e.g. TrayGraph) that keeps \param key for
+     * its whole life: always a change, and tinted without IconTint's cache
+     * so that frames shown once don't evict reusable entries.
+     */
+    void setIconFrame(const IconPixmapList &pixmaps, qint64 key);
+    /*!
+     * Recolours pixmap icons (symbolic style) with 0xAARRGGBB \param argb,
+     * kept across later icon changes; 0 shows the icon as given. Themed
+     * icon names are resolved by the host and are not affected.
+     */
+    void setIconTint(quint32 argb);
+    quint32 iconTint() const
+    { return mIconTint; }
 
     QString overlayIconName() const
     { return mOverlayIconName; }
@@ -98,6 +181,7 @@ public:
     IconPixmapList overlayIconPixmap() const
     { return mOverlayIcon; }
     void setOverlayIconByPixmap(const QIcon &icon);
+    void setOverlayIconByPixmaps(const IconPixmapList &pixmaps, qint64 key);
 
     QString attentionIconName() const
     { return mAttentionIconName; }
@@ -106,13 +190,30 @@ public:
     IconPixmapList attentionIconPixmap() const
     { return mAttentionIcon; }
     void setAttentionIconByPixmap(const QIcon &icon);
+    void setAttentionIconByPixmaps(const IconPixmapList &pixmaps, qint64 key);
+
+    QString attentionMovieName() const
+    { return mAttentionMovieName; }
+    /*!
+     * Animation played by the host while the status is NeedsAttention.
+     * \param name is looked up in IconThemePath (or is an absolute movie path).
+     * \param frames are pre-marshalled once: the first one is exported as the
+     * attention icon for hosts that ignore AttentionMovieName and, when
+     * \param frameIntervalMs > 0, they are cycled locally as a fallback —
+     * only if \param name is empty or the host does not play movies.
+     */
+    void setAttentionMovie(const QString &name, const QList<QIcon> &frames, int frameIntervalMs);
+
+    QString iconThemePath() const
+    { return mIconThemePath; }
+    void setIconThemePath(const QString &path);
 
     QString toolTipTitle() const
-    { return mTooltipTitle; }
+    { return mTooltipTitleProvider ? mTooltipTitleProvider.get() : mTooltipTitle; }
     void setToolTipTitle(const QString &title);
 
     QString toolTipSubTitle() const
-    { return mTooltipSubtitle; }
+    { return mTooltipSubtitleProvider ? mTooltipSubtitleProvider.get() : mTooltipSubtitle; }
     void setToolTipSubTitle(const QString &subTitle);
 
     QString toolTipIconName() const
@@ -126,13 +227,70 @@ public:
     ToolTip toolTip() const
     {
         ToolTip tt;
-        tt.title = mTooltipTitle;
-        tt.description = mTooltipSubtitle;
+        tt.title = toolTipTitle();
+        tt.description = toolTipSubTitle();
         tt.iconName = mTooltipIconName;
         tt.iconPixmap = mTooltipIcon;
         return tt;
     }
 
+    /*!
+     * Pull-model providers: the value is only computed when the host reads
+     * the property, then cached for \param ttlMs. An empty provider goes
+     * back to the pushed value. Setting or clearing a provider emits the
+     * New* signal once; after that, none is emitted until the value is
+     * marked stale with invalidateToolTip() / invalidateIcon().
+     */
+    void setToolTipTitleProvider(std::function<QString()> provider, int ttlMs);
+    void setToolTipSubTitleProvider(std::function<QString()> provider, int ttlMs);
+    void setIconProvider(std::function<QIcon()> provider, int ttlMs);
+    void invalidateToolTip();
+    void invalidateIcon();
+
+    /*!
+     * Batches changes: between beginUpdate() and the matching endUpdate()
+     * (nestable) the New* signals are only recorded, then each one that
+     * fired is emitted once, reflecting the final state.
+     */
+    void beginUpdate();
+    void endUpdate();
+
+    /*!
+     * Merges Scroll() calls per orientation: deltas are summed and
+     * scrollRequested is emitted at most once per \param windowMs (e.g. 16
+     * for one per frame). With \param notch > 0 only whole multiples of it
+     * are reported and the rest is carried over (reset when the direction
+     * flips). Both 0 (the default) reports every call unchanged.
+     */
+    void setScrollCoalescing(int windowMs, int notch);
+
+    enum ClickGesture {
+        SingleClick = 1,
+        DoubleClick = 2,
+        TripleClick = 3,
+        RepeatClick = 4     // every click past \a maxClicks in the same burst
+    };
+
+    /*!
+     * Recognises click bursts on Activate(): clicks closer than
+     * \param multiClickMs (<= 0: the platform double-click interval) form a
+     * burst, reported once through clickGestureRecognized() instead of
+     * activateRequested. Reaching \param maxClicks (1..3) reports at once,
+     * fewer clicks report when the burst times out.
+     */
+    void setClickGestures(bool enabled, int multiClickMs = 0, int maxClicks = 3);
+
+    /*!
+     * Sends a desktop notification without blocking the Qt thread;
+     * \param onReply (Qt thread) receives the server's notification id, or
+     * 0 if the call failed. Dropped if the item is destroyed first.
+     */
+    void showMessage(const QString &title, const QString &msg, const QString &iconName,
+                     int secs, std::function<void(quint32)> onReply);
+
+    /*! Converts \param icon to the big-endian ARGB list sent over D-Bus */
+    static IconPixmapList iconToPixmapList(const QIcon &icon);
+
     /*!
      * \Note: we don't take ownership for the \param menu
      */
@@ -151,17 +309,36 @@ public Q_SLOTS:
 
 private:
     void registerToHost();
-    IconPixmapList iconToPixmapList(const QIcon &icon);
+    void notifyPropertyChanged(const QString &name, const QVariant &value);
+
+    enum ChangedSignal {
+        TitleChanged         = 0x01,
+        IconChanged          = 0x02,
+        AttentionIconChanged = 0x04,
+        OverlayIconChanged   = 0x08,
+        ToolTipChanged       = 0x10,
+        StatusChanged        = 0x20
+    };
+    void emitChanged(ChangedSignal signal);
+    void updateAttentionAnimation();
+    void registerClick(const QPoint &pos);
+    void applyIconTint();
 
 private Q_SLOTS:
     void onServiceOwnerChanged(const QString &service, const QString &oldOwner,
                                const QString &newOwner);
     void onMenuDestroyed();
+    void onAttentionFrame();
+    void flushScroll();
+    void onClickBurstEnd();
 
 Q_SIGNALS:
     void activateRequested(const QPoint &pos);
     void secondaryActivateRequested(const QPoint &pos);
     void scrollRequested(int delta, Qt::Orientation orientation);
+    void clickGestureRecognized(int gesture, int clicks, const QPoint &pos);
+    /*! The watcher answered RegisterStatusNotifierItem (also on re-registration) */
+    void registrationFinished(bool registered);
 
 private:
     StatusNotifierItemAdaptor *mAdaptor;
@@ -176,18 +353,55 @@ private:
     QString mIconName, mOverlayIconName, mAttentionIconName;
     IconPixmapList mIcon, mOverlayIcon, mAttentionIcon;
     qint64 mIconCacheKey, mOverlayIconCacheKey, mAttentionIconCacheKey;
+    IconPixmapList mIconSource;     // icône avant teinte
+    qint64 mIconSourceKey;
+    quint32 mIconTint;
+    bool mIconIsFrame;              // source posée par setIconFrame()
+    QString mIconThemePath;
+
+    // attention animation
+    QString mAttentionMovieName;
+    QList<IconPixmapList> mAttentionFrames;
+    int mAttentionFrameIndex;
+    QTimer *mAttentionTimer;
 
     // tooltip
     QString mTooltipTitle, mTooltipSubtitle, mTooltipIconName;
     IconPixmapList mTooltipIcon;
     qint64 mTooltipIconCacheKey;
 
+    // pull-model providers
+    PulledValue<QString> mTooltipTitleProvider, mTooltipSubtitleProvider;
+    PulledValue<IconPixmapList> mIconProvider;
+
     // menu
     QMenu *mMenu;
     QDBusObjectPath mMenuPath;
+    bool mItemIsMenu;
     DBusMenuExporter *mMenuExporter;
     QDBusConnection mSessionBus;
 
+    // scroll coalescing
+    int mScrollWindowMs;
+    int mScrollNotch;
+    int mScrollAccum[2];        // [vertical, horizontal], non encore envoyé
+    int mScrollCarry[2];        // reliquat de crans reporté après un envoi
+    QTimer *mScrollTimer;
+
+    // click gestures
+    bool mClickGestures;
+    int mMaxClicks;
+    int mClickCount;
+    QPoint mClickPos;
+    QTimer *mClickTimer;
+
+    bool mPublished;
+    Registration mRegistration;
+
+    // New* différés pendant beginUpdate()/endUpdate()
+    int mUpdateDepth;
+    int mPendingSignals;
+
     static int mServiceCounter;
 };
 
@@ -0,0 +1,35 @@
+// File: svgrasterizer.h
+#pragma once
+
+#include <QByteArray>
+#include <QCache>
+#include <QList>
+
+#include "dbustypes.h"
+
+/**
+ * SvgRasterizer
+ * -------------
+ * • Rasterizes SVG sources with QSvgRenderer at exactly the sizes hosts use,
+ *   instead of going through QIcon, which re-renders on every pixmap() call.
+ * • Each (content hash, size, scale) is rendered once per process; missing
+ *   sizes of a request are rendered in parallel on the global thread pool.
+ * • Output is big-endian straight-alpha ARGB (IconPixmap wire format).
+ * • Called from the Qt thread.
+ */
+class SvgRasterizer
+{
+public:
+    static SvgRasterizer &instance();
+
+    /** True for SVG/SVGZ content (or when the hint says so) */
+    static bool isSvg(const QByteArray &data, const QByteArray &formatHint = QByteArray());
+
+    /** One pixmap per requested size (× scale), empty if `svg` is invalid */
+    IconPixmapList rasterize(const QByteArray &svg, const QList<int> &sizes, qreal scale = 1.0);
+
+private:
+    SvgRasterizer();
+
+    QCache<QByteArray, IconPixmap> mCache;
+};
@@ -0,0 +1,70 @@
+// File: textrenderer.h
+#pragma once
+
+#include <QCache>
+#include <QFont>
+#include <QHash>
+#include <QImage>
+#include <QString>
+
+#include "iconcache.h"
+
+/**
+ * TextIconRenderer
+ * ----------------
+ * • Turns a short string ("42°", "3", "OK") into a tray icon at every
+ *   standard size, natively, so callers don't render a bitmap per value.
+ * • Each (font, pixel size) owns a glyph atlas: a grey-level mask where
+ *   every code point is rasterised once by Qt, then only blitted. Layout
+ *   uses per-glyph advances (no kerning), which is fine for short labels.
+ * • Text is fitted to the tightest ink box (measured with QFontMetrics, so
+ *   only the chosen size gets an atlas) and centred; the background
+ *   colour (if not transparent) fills the whole square.
+ * • Finished icons are kept in an LRU keyed by text, font and colours:
+ *   a value that was shown recently costs a hash lookup and keeps its key,
+ *   so the tray sees no change at all.
+ * • Font spec: "Family", optionally suffixed ":bold"; empty = app font.
+ * • Only used from the Qt thread.
+ */
+class TextIconRenderer
+{
+public:
+    static TextIconRenderer &instance();
+
+    CachedIcon render(const QString &text, const QString &fontSpec,
+                      quint32 fgArgb, quint32 bgArgb);
+
+private:
+    struct Glyph
+    {
+        int x = 0, y = 0;           // position dans l'atlas
+        int width = 0, height = 0;
+        int left = 0, top = 0;      // décalage depuis l'origine (ligne de base)
+        int advance = 0;
+    };
+
+    class GlyphAtlas
+    {
+    public:
+        explicit GlyphAtlas(const QFont &font);
+        const Glyph &glyph(uint ucs4);
+        const uchar *mask(const Glyph &g, int row) const
+        { return mMask.constScanLine(g.y + row) + g.x; }
+
+    private:
+        QFont mFont;
+        QImage mMask;               // Format_Alpha8, grandit en hauteur
+        QHash<uint, Glyph> mGlyphs;
+        int mPenX = 0, mPenY = 0, mRowHeight = 0;
+    };
+
+    TextIconRenderer();
+
+    GlyphAtlas *atlas(const QFont &base, int pixelSize);
+    QRect inkBox(GlyphAtlas *atlas, const QVector<uint> &text);
+    IconPixmap renderSize(const QFont &base, const QVector<uint> &text, int side,
+                          quint32 fgArgb, quint32 bgArgb);
+
+    QCache<QString, GlyphAtlas> mAtlases;
+    QCache<QString, CachedIcon> mRecent;
+};
@@ -0,0 +1,109 @@
+// File: trayevents.h
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "sni_wrapper.h"
+
+class StatusNotifierItem;
+
+/**
+ * TrayEventRing
+ * -------------
+ * • Records the tray's activate / secondary / scroll / gesture / registration
+ *   signals into a fixed ring of sni_event, allocated once, so a consumer on
+ *   any thread can pull them instead of running code on the Qt thread.
+ * • One waiter at a time can arm a wait on an empty ring: the next event is
+ *   written straight into the waiter's buffer and its callback runs on the
+ *   Qt thread, outside the lock (it may re-arm at once).
+ * • cancel() is a handshake: when the wait was already taken, it returns
+ *   only once the callback has returned (unless called from that callback),
+ *   so the waiter may be freed right after.
+ * • Overflow drops the oldest event; the count is reported with the next
+ *   event handed out.
+ * • A child of its StatusNotifierItem; its destruction wakes a pending
+ *   waiter with SNI_EVENT_CLOSED. Ring state is guarded by sLock.
+ */
+class TrayEventRing : public QObject
+{
+    Q_OBJECT
+public:
+    /** Installs a ring of `capacity` events on `sni` (Qt thread); <= 0 removes it */
+    static void install(StatusNotifierItem *sni, int capacity);
+    static void forget(StatusNotifierItem *sni);
+
+    /** Any thread: see tray_poll_event / tray_next_event / tray_cancel_event_wait */
+    static bool poll(StatusNotifierItem *sni, sni_event *out);
+    static int next(StatusNotifierItem *sni, sni_event *out, EventReadyCallback cb, void *data);
+    static bool cancel(StatusNotifierItem *sni, void *data);
+
+    ~TrayEventRing() override;
+
+private:
+    TrayEventRing(StatusNotifierItem *sni, int capacity);
+
+    void push(const sni_event &event);
+    bool popLocked(sni_event *out);
+
+    StatusNotifierItem *mSni;
+
+    // Protégés par sLock
+    QVector<sni_event> mRing;
+    int mHead;
+    int mCount;
+    unsigned int mDropped;
+
+    sni_event *mWaitOut;
+    EventReadyCallback mWaitCb;
+    void *mWaitData;
+
+    /* Runs cb(data) outside sLock, with `data` marked in flight */
+    static void fire(EventReadyCallback cb, void *data);
+
+    static QMutex sLock;
+    static QHash<StatusNotifierItem*, TrayEventRing*> sRings;
+    static QHash<void*, Qt::HANDLE> sFiring;      // data → thread du rappel
+    static QWaitCondition sFired;
+};
+
+/**
+ * TrayReplies
+ * -----------
+ * • Pending async D-Bus replies (Notify, watcher registration) handed back
+ *   through AsyncReplyCallback, keyed by the caller's data pointer.
+ * • finish() and cancel() race under one lock, so a cancelled reply never
+ *   reaches its callback; the callback itself runs outside the lock, and a
+ *   cancel() that lost the race waits for it to return (as TrayEventRing).
+ * • abandon() completes every reply still pending for a destroyed tray
+ *   with 0, so no waiter is left hanging.
+ */
+class TrayReplies
+{
+public:
+    /** Returns the serial that finish() must present */
+    static quint64 begin(StatusNotifierItem *sni, AsyncReplyCallback cb, void *data);
+    static void finish(void *data, quint64 serial, unsigned int result);
+    static bool cancel(void *data);
+    static void abandon(StatusNotifierItem *sni);
+
+private:
+    struct Pending
+    {
+        StatusNotifierItem *sni;
+        AsyncReplyCallback cb;
+        quint64 serial;
+    };
+
+    static void fire(AsyncReplyCallback cb, unsigned int result, void *data);
+
+    static QMutex sLock;
+    static QHash<void*, Pending> sPending;
+    static quint64 sSerial;
+    static QHash<void*, Qt::HANDLE> sFiring;
+    static QWaitCondition sFired;
+};
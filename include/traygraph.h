@@ -0,0 +1,92 @@
+// File: traygraph.h
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+
+#include "dbustypes.h"
+
+class StatusNotifierItem;
+
+/**
+ * TrayGraph
+ * ---------
+ * • Sparkline icon (CPU, network, …): one column per sample, newest on the
+ *   right, drawn at every standard icon size from a per-tray ring buffer.
+ * • Incremental: each frame copies the previous frame's ARGB rows shifted
+ *   left by the number of new samples and paints only the new columns. A
+ *   full redraw happens only when the scale changes (auto-range) or the
+ *   style changes.
+ * • Double-buffered: the tray holds the front frames while the next ones
+ *   are drawn into the back buffer, which the tray released when it got
+ *   the front, so no frame is ever deep-copied. One icon key serves the
+ *   graph's whole life (StatusNotifierItem::setIconFrame()).
+ * • push() may be called from any thread at any rate: it appends under a
+ *   short lock and, after releasing it, posts at most one flush (a
+ *   Background tick, never dropped by the queue limits); frames are capped
+ *   at maxFps.
+ * • A child of its StatusNotifierItem (dies with it); lives in the Qt thread.
+ */
+class TrayGraph : public QObject
+{
+    Q_OBJECT
+public:
+    struct Style
+    {
+        float   min    = 0.f;           // min >= max : échelle automatique
+        float   max    = 1.f;
+        quint32 line   = 0xff3daee9;    // 0xAARRGGBB
+        quint32 fill   = 0x803daee9;
+        quint32 bg     = 0x00000000;
+        int     maxFps = 4;
+    };
+
+    /** Graph of `sni`, created on first use (Qt thread) */
+    static TrayGraph *ensure(StatusNotifierItem *sni);
+    /** Drops the graph of `sni`, if any (Qt thread) */
+    static void forget(StatusNotifierItem *sni);
+    /** Queues a sample; false if `sni` has no graph yet (any thread) */
+    static bool push(StatusNotifierItem *sni, float sample);
+
+    void setStyle(const Style &style);
+
+    ~TrayGraph() override;
+
+private Q_SLOTS:
+    void flush();
+    void render();
+
+private:
+    explicit TrayGraph(StatusNotifierItem *sni);
+
+    float sampleAt(int age) const;
+    bool updateRange();
+    void drawColumn(uchar *pixels, int side, int x, int age);
+
+    StatusNotifierItem *mSni;
+    Style mStyle;
+
+    QVector<float> mRing;
+    int mHead;
+    int mCount;
+    int mNewColumns;
+    bool mFullRedraw;
+    float mLo, mHi;
+
+    IconPixmapList mFrames[2];
+    int mFront;                         // tampon détenu par le tray
+    qint64 mKey;
+    QElapsedTimer mLastRender;
+    QTimer mThrottle;
+
+    // Protégés par sLock
+    QVector<float> mPending;
+    bool mScheduled;
+
+    static QMutex sLock;
+    static QHash<StatusNotifierItem*, TrayGraph*> sGraphs;
+};
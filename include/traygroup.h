@@ -0,0 +1,47 @@
+// File: traygroup.h
+#pragma once
+
+#include <QList>
+#include <QMutex>
+#include <QPointer>
+
+#include <functional>
+
+class StatusNotifierItem;
+
+/**
+ * TrayGroup
+ * ---------
+ * • A set of trays that change together (status, icon, title, …): one
+ *   group-wide setter is one Qt-thread hop for every member instead of one
+ *   blocking call per tray.
+ * • begin()/commit() batching: changes are queued on the caller's side and
+ *   applied together at commit, still in a single hop.
+ * • Each member is wrapped in beginUpdate()/endUpdate() while the changes
+ *   run, so every tray emits each New* signal at most once per flush.
+ * • Membership and the queue are guarded by a mutex; changes run in the Qt
+ *   thread, and members destroyed meanwhile are skipped (QPointer).
+ */
+class TrayGroup
+{
+public:
+    using Change = std::function<void(StatusNotifierItem *)>;
+
+    void add(StatusNotifierItem *sni);
+    void remove(StatusNotifierItem *sni);
+
+    void begin();
+    /** Queues `change` when batching (returns true), otherwise false */
+    bool defer(const Change &change);
+    /** Ends the batch, returning the queued changes */
+    QList<Change> takePending();
+
+    /** Runs `changes` on every live member (Qt thread) */
+    void apply(const QList<Change> &changes);
+
+private:
+    mutable QMutex mLock;
+    QList<QPointer<StatusNotifierItem>> mMembers;
+    QList<Change> mPending;
+    bool mBatching = false;
+};
@@ -0,0 +1,51 @@
+// File: valuemap.h
+#pragma once
+
+#include <QObject>
+#include <QVector>
+
+class StatusNotifierItem;
+class SharedIcon;
+
+/**
+ * TrayValueMap
+ * ------------
+ * • Maps a number onto one of N icons (battery, signal, load, …): bucket i
+ *   covers [threshold[i], threshold[i+1]); values under threshold[0] use
+ *   bucket 0.
+ * • setValue() is an upper_bound over the sorted thresholds. With
+ *   hysteresis h, the current bucket is only left once the value is more
+ *   than h past one of its edges, so noise around a boundary doesn't flap.
+ * • The icon (and NewIcon) changes only when the bucket changes.
+ * • Holds a reference on each SharedIcon; a child of its
+ *   StatusNotifierItem, lives in the Qt thread.
+ */
+class TrayValueMap : public QObject
+{
+    Q_OBJECT
+public:
+    /** Installs a new map on `sni`; `thresholds` must be ascending */
+    static TrayValueMap *install(StatusNotifierItem *sni, const QVector<double> &thresholds,
+                                 const QVector<SharedIcon*> &icons, double hysteresis);
+    /** Map of `sni`, or nullptr */
+    static TrayValueMap *of(StatusNotifierItem *sni);
+    static void forget(StatusNotifierItem *sni);
+
+    void setValue(double value);
+    int bucket() const { return mBucket; }
+
+    ~TrayValueMap() override;
+
+private:
+    TrayValueMap(StatusNotifierItem *sni, const QVector<double> &thresholds,
+                 const QVector<SharedIcon*> &icons, double hysteresis);
+
+    int lookup(double value) const;
+    void apply();
+
+    StatusNotifierItem *mSni;
+    QVector<double> mThresholds;
+    QVector<SharedIcon*> mIcons;
+    double mHysteresis;
+    int mBucket;
+};
@@ -0,0 +1,193 @@
+#include "colorscheme.h"
+#include "iconcache.h"
+#include "statusnotifieritem.h"
+#include "qtthreadmanager.h"
+
+#include <QAction>
+#include <QCoreApplication>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusReply>
+#include <QPointer>
+
+static const char *kPortalPath      = "/org/freedesktop/portal/desktop";
+static const char *kSettingsIface   = "org.freedesktop.portal.Settings";
+static const char *kAppearanceNs    = "org.freedesktop.appearance";
+static const char *kColorSchemeKey  = "color-scheme";
+
+// Rattaché à la QApplication : recréé avec elle après un arrêt du thread Qt
+static QPointer<ColorSchemeWatcher> g_colorScheme;
+
+ColorSchemeWatcher *ColorSchemeWatcher::instance()
+{
+    if (!g_colorScheme)
+        g_colorScheme = new ColorSchemeWatcher(QCoreApplication::instance());
+    return g_colorScheme;
+}
+
+void ColorSchemeWatcher::forget(StatusNotifierItem *sni)
+{
+    if (g_colorScheme && g_colorScheme->mTrays.contains(sni)) {
+        Variants v = g_colorScheme->mTrays.take(sni);
+        release(v);
+    }
+}
+
+void ColorSchemeWatcher::forget(QAction *action)
+{
+    if (g_colorScheme && g_colorScheme->mActions.contains(action)) {
+        Variants v = g_colorScheme->mActions.take(action);
+        release(v);
+    }
+}
+
+ColorSchemeWatcher::ColorSchemeWatcher(QObject *parent)
+    : QObject(parent)
+{
+    mService = qEnvironmentVariable("SNI_SETTINGS_PORTAL_SERVICE",
+                                    QStringLiteral("org.freedesktop.portal.Desktop"));
+
+    // Plusieurs signaux rapprochés → une seule mise à jour
+    mApplyTimer.setSingleShot(true);
+    mApplyTimer.setInterval(0);
+    connect(&mApplyTimer, &QTimer::timeout, this, [this]() {
+        QPointer<ColorSchemeWatcher> self(this);
+        QtThreadManager::post(QtThreadManager::Lane::Visible, [self]() {
+            if (self)
+                self->applyAll();
+        }, this, 0, QtThreadManager::Entry::Tick);
+    });
+
+    QDBusConnection::sessionBus().connect(mService, QLatin1String(kPortalPath),
+                                          QLatin1String(kSettingsIface), QStringLiteral("SettingChanged"),
+                                          this, SLOT(onSettingChanged(QString,QString,QDBusVariant)));
+    mAppliedDark = isDark();
+    readInitial(QStringLiteral("ReadOne"));
+}
+
+ColorSchemeWatcher::~ColorSchemeWatcher()
+{
+    for (Variants &v : mTrays)
+        release(v);
+    for (Variants &v : mActions)
+        release(v);
+}
+
+/* color-scheme : 0 = sans préférence, 1 = sombre, 2 = clair */
+static bool schemeIsDark(const QVariant &value)
+{
+    QVariant v = value;
+    while (v.userType() == qMetaTypeId<QDBusVariant>())
+        v = v.value<QDBusVariant>().variant();
+    return v.toUInt() == 1;
+}
+
+/* Lecture initiale asynchrone : sans portail, le thread Qt ne doit pas attendre */
+void ColorSchemeWatcher::readInitial(const QString &method)
+{
+    QDBusMessage msg = QDBusMessage::createMethodCall(mService, QLatin1String(kPortalPath),
+                                                      QLatin1String(kSettingsIface), method);
+    msg << QLatin1String(kAppearanceNs) << QLatin1String(kColorSchemeKey);
+
+    auto *watcher = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(msg, 1000), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, method](QDBusPendingCallWatcher *call) {
+        call->deleteLater();
+        const QDBusMessage reply = call->reply();
+
+        // Anciens portails : seulement Read (variant dans un variant)
+        if (reply.type() != QDBusMessage::ReplyMessage) {
+            if (method == QLatin1String("ReadOne"))
+                readInitial(QStringLiteral("Read"));
+            return;
+        }
+
+        // Un SettingChanged arrivé entre-temps est plus récent
+        if (mPortalKnown || reply.arguments().isEmpty())
+            return;
+        mPortalKnown = true;
+        mPortalDark = schemeIsDark(reply.arguments().constFirst());
+        mApplyTimer.start();
+    });
+}
+
+bool ColorSchemeWatcher::isDark() const
+{
+    return mForced >= 0 ? mForced == 1 : mPortalDark;
+}
+
+void ColorSchemeWatcher::setForced(int scheme)
+{
+    mForced = scheme < 0 ? -1 : (scheme == 1 ? 1 : 0);
+    mApplyTimer.start();
+}
+
+void ColorSchemeWatcher::onSettingChanged(const QString &ns, const QString &key, const QDBusVariant &value)
+{
+    if (ns != QLatin1String(kAppearanceNs) || key != QLatin1String(kColorSchemeKey))
+        return;
+
+    mPortalKnown = true;
+    mPortalDark = schemeIsDark(value.variant());
+    mApplyTimer.start();
+}
+
+void ColorSchemeWatcher::applyAll()
+{
+    const bool dark = isDark();
+    if (dark == mAppliedDark)
+        return;
+    mAppliedDark = dark;
+
+    for (auto it = mTrays.cbegin(); it != mTrays.cend(); ++it)
+        apply(it.key(), it.value(), dark);
+    for (auto it = mActions.cbegin(); it != mActions.cend(); ++it)
+        apply(it.key(), it.value(), dark);
+}
+
+void ColorSchemeWatcher::apply(StatusNotifierItem *sni, const Variants &v, bool dark)
+{
+    const SharedIcon *icon = dark ? v.dark : v.light;
+    if (!icon->themeName().isEmpty())
+        sni->setIconByName(icon->themeName());
+    else
+        sni->setIconByPixmaps(icon->pixmaps().pixmaps, icon->pixmaps().key);
+}
+
+void ColorSchemeWatcher::apply(QAction *action, const Variants &v, bool dark)
+{
+    action->setIcon((dark ? v.dark : v.light)->icon());
+}
+
+void ColorSchemeWatcher::release(Variants &v)
+{
+    if (v.light) v.light->deref();
+    if (v.dark)  v.dark->deref();
+    v = Variants();
+}
+
+void ColorSchemeWatcher::setThemedIcon(StatusNotifierItem *sni, SharedIcon *light, SharedIcon *dark)
+{
+    forget(sni);
+    light->ref();
+    dark->ref();
+
+    disconnect(sni, &QObject::destroyed, this, nullptr);
+    connect(sni, &QObject::destroyed, this, [sni]() { forget(sni); });
+    mTrays.insert(sni, Variants { light, dark });
+
+    apply(sni, mTrays.value(sni), isDark());
+}
+
+void ColorSchemeWatcher::setThemedIcon(QAction *action, SharedIcon *light, SharedIcon *dark)
+{
+    forget(action);
+    light->ref();
+    dark->ref();
+
+    disconnect(action, &QObject::destroyed, this, nullptr);
+    connect(action, &QObject::destroyed, this, [action]() { forget(action); });
+    mActions.insert(action, Variants { light, dark });
+
+    apply(action, mActions.value(action), isDark());
+}
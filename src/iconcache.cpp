@@ -0,0 +1,283 @@
+#include "iconcache.h"
+#include "statusnotifieritem.h"
+#include "pngdecoder.h"
+#include "iconscaler.h"
+#include "svgrasterizer.h"
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QIcon>
+#include <QImage>
+#include <QImageReader>
+#include <QPixmap>
+#include <QtEndian>
+
+// Au-delà, la taille native n'est pas envoyée (seulement les tailles réduites)
+static const int kMaxNativeSide = 256;
+
+// Coût des entrées = octets ARGB marshallés ; ~8 Mo au total
+static const int kFileCacheBytes = 8 * 1024 * 1024;
+
+IconCache &IconCache::instance()
+{
+    static IconCache cache;
+    return cache;
+}
+
+IconCache::IconCache()
+    : mFiles(kFileCacheBytes),
+      mEncoded(kFileCacheBytes)
+{
+}
+
+IconCache::EncodedEntry::EncodedEntry(SharedIcon *icon)
+    : icon(icon)
+{
+    icon->ref();
+}
+
+IconCache::EncodedEntry::~EncodedEntry()
+{
+    icon->deref();
+}
+
+const QList<int> &IconCache::standardSizes()
+{
+    static const QList<int> sizes = { 16, 22, 24, 32, 48 };
+    return sizes;
+}
+
+IconPixmapList IconCache::withStandardSizes(const IconPixmap &native)
+{
+    IconPixmapList list;
+    const int longest = qMax(native.width, native.height);
+    if (longest <= 0)
+        return list;
+
+    IconScaler scaler(reinterpret_cast<const uint8_t *>(native.bytes.constData()),
+                      native.width, native.height);
+    for (int side : standardSizes()) {
+        if (side >= longest)
+            break;
+        IconScaler::Level level = scaler.scaled(side);
+        IconPixmap p;
+        p.width  = level.width;
+        p.height = level.height;
+        p.bytes  = QByteArray(reinterpret_cast<const char *>(level.argb.data()), int(level.argb.size()));
+        list.append(p);
+    }
+
+    if (longest <= kMaxNativeSide || list.isEmpty())
+        list.append(native);
+    return list;
+}
+
+qint64 IconCache::nextKey()
+{
+    static qint64 s_key = 0;
+    return --s_key;
+}
+
+static int pixmapBytes(const IconPixmapList &pixmaps)
+{
+    int bytes = 0;
+    for (const IconPixmap &p : pixmaps)
+        bytes += p.bytes.size();
+    return qMax(bytes, 1);
+}
+
+/* Chemin rapide PNG : octets → ARGB big-endian sans QImage, puis réduction */
+static bool decodePng(const QByteArray &bytes, IconPixmapList *out)
+{
+    const auto *data = reinterpret_cast<const uint8_t *>(bytes.constData());
+    PngDecoder decoder(data, size_t(bytes.size()));
+    if (!decoder.readHeader())
+        return false;
+
+    IconPixmap p;
+    p.width  = decoder.width();
+    p.height = decoder.height();
+    p.bytes.resize(p.width * p.height * 4);
+    if (!decoder.decode(reinterpret_cast<uint8_t *>(p.bytes.data())))
+        return false;
+
+    // Toutes les tailles depuis ce seul décodage
+    out->append(IconCache::withStandardSizes(p));
+    return true;
+}
+
+CachedIcon IconCache::fromFile(const QString &path)
+{
+    const QFileInfo info(path);
+    const qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+    const qint64 size  = info.size();
+
+    if (FileEntry *entry = mFiles.object(path)) {
+        if (entry->mtime == mtime && entry->size == size)
+            return entry->icon;
+    }
+
+    auto *entry = new FileEntry;
+    entry->mtime = mtime;
+    entry->size  = size;
+    QFile file(path);
+    const QByteArray magic = file.open(QIODevice::ReadOnly) ? file.peek(8) : QByteArray();
+    const bool png = PngDecoder::isPng(reinterpret_cast<const uint8_t *>(magic.constData()),
+                                       size_t(magic.size()));
+    const bool svg = !png && path.endsWith(QLatin1String(".svg"), Qt::CaseInsensitive);
+    if (png || svg) {
+        const QByteArray bytes = file.readAll();
+        if (png)
+            decodePng(bytes, &entry->icon.pixmaps);
+        else
+            entry->icon.pixmaps = SvgRasterizer::instance().rasterize(bytes, standardSizes());
+    }
+    if (entry->icon.pixmaps.isEmpty())
+        entry->icon.pixmaps = StatusNotifierItem::iconToPixmapList(QIcon(path));
+    entry->icon.key = nextKey();
+
+    const CachedIcon icon = entry->icon;
+    if (!icon.isNull())
+        mFiles.insert(path, entry, pixmapBytes(icon.pixmaps));
+    else
+        delete entry;
+    return icon;
+}
+
+SharedIcon *IconCache::fromEncoded(const QByteArray &data, const QByteArray &formatHint)
+{
+    const QByteArray key = QCryptographicHash::hash(data, QCryptographicHash::Md5) + formatHint;
+
+    if (EncodedEntry *entry = mEncoded.object(key)) {
+        entry->icon->ref();
+        return entry->icon;
+    }
+
+    IconPixmapList pixmaps;
+    if (decodePng(data, &pixmaps)) {
+        SharedIcon *icon = SharedIcon::fromPixmaps(CachedIcon { nextKey(), pixmaps });
+        mEncoded.insert(key, new EncodedEntry(icon), pixmapBytes(pixmaps));
+        return icon;
+    }
+
+    if (SvgRasterizer::isSvg(data, formatHint)) {
+        pixmaps = SvgRasterizer::instance().rasterize(data, standardSizes());
+        if (!pixmaps.isEmpty()) {
+            SharedIcon *icon = SharedIcon::fromPixmaps(CachedIcon { nextKey(), pixmaps });
+            mEncoded.insert(key, new EncodedEntry(icon), pixmapBytes(pixmaps));
+            return icon;
+        }
+    }
+
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+
+    QImageReader reader(&buffer, formatHint);
+    reader.setDecideFormatFromContent(true);
+    const QImage img = reader.read();
+    if (img.isNull())
+        return nullptr;
+
+    SharedIcon *icon = SharedIcon::fromImage(img);
+    mEncoded.insert(key, new EncodedEntry(icon), pixmapBytes(icon->pixmaps().pixmaps));
+    return icon;
+}
+
+void IconCache::invalidate(const QString &path)
+{
+    mFiles.remove(path);
+}
+
+/* ------------------------------------------------------------------ *
+ *  SharedIcon                                                        *
+ * ------------------------------------------------------------------ */
+SharedIcon *SharedIcon::fromPathOrName(const QString &pathOrName)
+{
+    auto *icon = new SharedIcon;
+
+    if (QFileInfo::exists(pathOrName)) {
+        icon->mIcon    = QIcon(pathOrName);
+        icon->mPixmaps = IconCache::instance().fromFile(pathOrName);
+    } else {
+        icon->mThemeName = pathOrName;
+        icon->mIcon      = QIcon::fromTheme(pathOrName);
+        icon->mPixmaps.key = IconCache::nextKey();
+    }
+    return icon;
+}
+
+SharedIcon *SharedIcon::fromImage(const QImage &image)
+{
+    auto *icon = new SharedIcon;
+    icon->mIcon = QIcon(QPixmap::fromImage(image));
+    icon->mPixmaps.pixmaps = StatusNotifierItem::iconToPixmapList(icon->mIcon);
+    icon->mPixmaps.key = IconCache::nextKey();
+    return icon;
+}
+
+SharedIcon *SharedIcon::fromPixmaps(const CachedIcon &pixmaps)
+{
+    auto *icon = new SharedIcon;
+    icon->mPixmaps = pixmaps;
+    return icon;
+}
+
+const QIcon &SharedIcon::icon() const
+{
+    // Icône Qt construite à la demande depuis les pixmaps (menus seulement)
+    if (mIcon.isNull() && mThemeName.isEmpty()) {
+        for (const IconPixmap &p : mPixmaps.pixmaps) {
+            QImage img(p.width, p.height, QImage::Format_ARGB32);
+            const auto *in = reinterpret_cast<const quint32 *>(p.bytes.constData());
+            for (int y = 0; y < p.height; ++y) {
+                auto *line = reinterpret_cast<quint32 *>(img.scanLine(y));
+                for (int x = 0; x < p.width; ++x)
+                    line[x] = qFromBigEndian(*in++);
+            }
+            mIcon.addPixmap(QPixmap::fromImage(img));
+        }
+    }
+    return mIcon;
+}
+
+SharedIcon *SharedIcon::fromArgb(const quint32 *argb, int width, int height)
+{
+    // 4096² × 4 octets tient dans un int : pas de débordement plus bas
+    if (width <= 0 || height <= 0 || width > kMaxArgbSide || height > kMaxArgbSide)
+        return nullptr;
+
+    auto *icon = new SharedIcon;
+    const int count = width * height;
+
+    IconPixmap p;
+    p.width  = width;
+    p.height = height;
+    p.bytes.resize(count * int(sizeof(quint32)));
+
+    // D-Bus attend de l'ARGB big-endian : une seule passe de conversion
+    auto *out = reinterpret_cast<quint32 *>(p.bytes.data());
+    for (int i = 0; i < count; ++i)
+        out[i] = qToBigEndian(argb[i]);
+
+    icon->mPixmaps.pixmaps = IconCache::withStandardSizes(p);
+    icon->mPixmaps.key = IconCache::nextKey();
+
+    QImage img(reinterpret_cast<const uchar *>(argb), width, height, QImage::Format_ARGB32);
+    icon->mIcon = QIcon(QPixmap::fromImage(img.copy()));
+    return icon;
+}
+
+void SharedIcon::ref()
+{
+    mRefs.ref();
+}
+
+void SharedIcon::deref()
+{
+    if (!mRefs.deref())
+        delete this;
+}
@@ -0,0 +1,163 @@
+#include "iconscaler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/* ------------------------------------------------------------------ *
+ *  4-float vector: vector extensions when available, scalar else      *
+ * ------------------------------------------------------------------ */
+#if defined(__GNUC__) || defined(__clang__)
+typedef float v4f __attribute__((vector_size(16)));
+static inline v4f splat(float f) { return v4f{ f, f, f, f }; }
+#else
+struct v4f
+{
+    float v[4];
+    float &operator[](int i) { return v[i]; }
+    float operator[](int i) const { return v[i]; }
+};
+static inline v4f operator+(v4f a, v4f b) { for (int i = 0; i < 4; ++i) a.v[i] += b.v[i]; return a; }
+static inline v4f operator*(v4f a, v4f b) { for (int i = 0; i < 4; ++i) a.v[i] *= b.v[i]; return a; }
+static inline v4f splat(float f) { return v4f{ { f, f, f, f } }; }
+#endif
+
+static inline v4f load(const float *p)
+{
+    v4f r;
+    std::memcpy(&r, p, sizeof(r));
+    return r;
+}
+
+static inline void store(float *p, v4f v)
+{
+    std::memcpy(p, &v, sizeof(v));
+}
+
+/* ------------------------------------------------------------------ *
+ *  sRGB <-> linear tables                                            *
+ * ------------------------------------------------------------------ */
+static const int kLinearSteps = 4096;
+
+struct GammaTables
+{
+    float   toLinear[256];
+    uint8_t toSrgb[kLinearSteps + 1];
+
+    GammaTables()
+    {
+        for (int i = 0; i < 256; ++i) {
+            const double c = i / 255.0;
+            toLinear[i] = float(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+        }
+        for (int i = 0; i <= kLinearSteps; ++i) {
+            const double l = double(i) / kLinearSteps;
+            const double c = l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+            toSrgb[i] = uint8_t(std::lround(std::min(1.0, std::max(0.0, c)) * 255.0));
+        }
+    }
+};
+
+static const GammaTables &gamma()
+{
+    static const GammaTables tables;
+    return tables;
+}
+
+/* ------------------------------------------------------------------ *
+ *  Box-filter contributions for one axis                             *
+ * ------------------------------------------------------------------ */
+struct Span
+{
+    int first;
+    std::vector<float> weights;
+};
+
+static std::vector<Span> spans(int src, int dst)
+{
+    std::vector<Span> out(static_cast<size_t>(dst));
+    const double scale = double(src) / dst;
+
+    for (int i = 0; i < dst; ++i) {
+        const double lo = i * scale;
+        const double hi = std::min(double(src), (i + 1) * scale);
+        Span &s = out[size_t(i)];
+        s.first = int(lo);
+        for (int j = s.first; j < src && j < hi; ++j) {
+            const double cover = std::min(hi, j + 1.0) - std::max(lo, double(j));
+            s.weights.push_back(float(cover / scale));
+        }
+    }
+    return out;
+}
+
+/* ------------------------------------------------------------------ */
+
+IconScaler::IconScaler(const uint8_t *argb, int width, int height)
+    : mWidth(width), mHeight(height), mLinear(size_t(width) * size_t(height))
+{
+    const GammaTables &g = gamma();
+    for (size_t i = 0; i < mLinear.size(); ++i, argb += 4) {
+        const float a = argb[0] / 255.0f;
+        Lin4 &p = mLinear[i];
+        p.v[0] = a;
+        p.v[1] = g.toLinear[argb[1]] * a;
+        p.v[2] = g.toLinear[argb[2]] * a;
+        p.v[3] = g.toLinear[argb[3]] * a;
+    }
+}
+
+IconScaler::Level IconScaler::scaled(int side) const
+{
+    Level level;
+    if (mWidth <= 0 || mHeight <= 0 || side <= 0)
+        return level;
+
+    const int longest = std::max(mWidth, mHeight);
+    if (side > longest)
+        side = longest;
+    level.width  = mWidth >= mHeight ? side : std::max(1, int(std::lround(double(side) * mWidth / mHeight)));
+    level.height = mHeight >= mWidth ? side : std::max(1, int(std::lround(double(side) * mHeight / mWidth)));
+
+    const std::vector<Span> xs = spans(mWidth, level.width);
+    const std::vector<Span> ys = spans(mHeight, level.height);
+
+    // Passe horizontale : mHeight lignes × level.width
+    std::vector<Lin4> rows(size_t(mHeight) * size_t(level.width));
+    for (int y = 0; y < mHeight; ++y) {
+        const Lin4 *in = &mLinear[size_t(y) * size_t(mWidth)];
+        Lin4 *out = &rows[size_t(y) * size_t(level.width)];
+        for (int x = 0; x < level.width; ++x) {
+            const Span &s = xs[size_t(x)];
+            v4f acc = splat(0.0f);
+            for (size_t k = 0; k < s.weights.size(); ++k)
+                acc = acc + load(in[size_t(s.first) + k].v) * splat(s.weights[k]);
+            store(out[x].v, acc);
+        }
+    }
+
+    // Passe verticale + retour sRGB non prémultiplié, octets A R G B
+    const GammaTables &g = gamma();
+    level.argb.resize(size_t(level.width) * size_t(level.height) * 4);
+    uint8_t *dst = level.argb.data();
+    for (int y = 0; y < level.height; ++y) {
+        const Span &s = ys[size_t(y)];
+        for (int x = 0; x < level.width; ++x, dst += 4) {
+            v4f acc = splat(0.0f);
+            for (size_t k = 0; k < s.weights.size(); ++k)
+                acc = acc + load(rows[(size_t(s.first) + k) * size_t(level.width) + size_t(x)].v)
+                            * splat(s.weights[k]);
+
+            const float a = std::min(1.0f, std::max(0.0f, float(acc[0])));
+            if (a <= 0.0f) {
+                std::memset(dst, 0, 4);
+                continue;
+            }
+            const v4f c = acc * splat(kLinearSteps / a);
+            dst[0] = uint8_t(std::lround(a * 255.0f));
+            for (int i = 1; i < 4; ++i)
+                dst[i] = g.toSrgb[std::min(kLinearSteps, std::max(0, int(c[i] + 0.5f)))];
+        }
+    }
+    return level;
+}
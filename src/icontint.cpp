@@ -0,0 +1,92 @@
+#include "icontint.h"
+
+#include <cstring>
+
+// Coût = octets ARGB ; ~2 Mo d'icônes teintées
+static const int kTintCacheBytes = 2 * 1024 * 1024;
+
+// Octet alpha en tête (ARGB big-endian) : position dans un mot natif
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+static const int kAlphaShift = 0;
+#else
+static const int kAlphaShift = 24;
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+typedef quint32 v4u __attribute__((vector_size(16)));
+#endif
+
+/* out = teinte RGB | alpha_source * alpha_teinte / 255, mot par mot */
+static void tintPixels(const quint32 *in, quint32 *out, int count, quint32 rgbWord, quint32 tintAlpha)
+{
+    int i = 0;
+#if defined(__GNUC__) || defined(__clang__)
+    const v4u rgb    = { rgbWord, rgbWord, rgbWord, rgbWord };
+    const v4u ta     = { tintAlpha, tintAlpha, tintAlpha, tintAlpha };
+    const v4u mask   = { 0xffu, 0xffu, 0xffu, 0xffu };
+    const v4u round  = { 128u, 128u, 128u, 128u };
+    for (; i + 4 <= count; i += 4) {
+        v4u px;
+        std::memcpy(&px, in + i, sizeof(px));
+        v4u a = (px >> kAlphaShift) & mask;
+        a = a * ta + round;
+        a = (a + (a >> 8)) >> 8;                // ≈ a * ta / 255, arrondi
+        px = rgb | (a << kAlphaShift);
+        std::memcpy(out + i, &px, sizeof(px));
+    }
+#endif
+    for (; i < count; ++i) {
+        quint32 a = ((in[i] >> kAlphaShift) & 0xffu) * tintAlpha + 128u;
+        a = (a + (a >> 8)) >> 8;
+        out[i] = rgbWord | (a << kAlphaShift);
+    }
+}
+
+IconTint &IconTint::instance()
+{
+    static IconTint tint;
+    return tint;
+}
+
+IconTint::IconTint()
+    : mCache(kTintCacheBytes)
+{
+}
+
+CachedIcon IconTint::apply(const CachedIcon &source, quint32 argb)
+{
+    const QPair<qint64, quint32> key(source.key, argb);
+    if (CachedIcon *hit = mCache.object(key))
+        return *hit;
+
+    CachedIcon tinted;
+    tinted.key = IconCache::nextKey();
+    tinted.pixmaps = recolour(source.pixmaps, argb);
+
+    int bytes = 0;
+    for (const IconPixmap &p : qAsConst(tinted.pixmaps))
+        bytes += p.bytes.size();
+    mCache.insert(key, new CachedIcon(tinted), qMax(bytes, 1));
+    return tinted;
+}
+
+IconPixmapList IconTint::recolour(const IconPixmapList &source, quint32 argb)
+{
+    // Mot « 0 R G B » dans l'ordre des octets du fil, alpha laissé à zéro
+    const uchar rgbBytes[4] = { 0, uchar(argb >> 16), uchar(argb >> 8), uchar(argb) };
+    quint32 rgbWord;
+    std::memcpy(&rgbWord, rgbBytes, sizeof(rgbWord));
+
+    IconPixmapList out;
+    for (const IconPixmap &src : source) {
+        IconPixmap p;
+        p.width  = src.width;
+        p.height = src.height;
+        p.bytes.resize(src.bytes.size());
+        tintPixels(reinterpret_cast<const quint32 *>(src.bytes.constData()),
+                   reinterpret_cast<quint32 *>(p.bytes.data()),
+                   src.bytes.size() / 4, rgbWord, argb >> 24);
+        out.append(p);
+    }
+    return out;
+}
@@ -0,0 +1,156 @@
+#include "iconwatcher.h"
+#include "iconcache.h"
+#include "statusnotifieritem.h"
+#include "qtthreadmanager.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QPointer>
+
+// Regroupe les rafales d'écritures (générateur qui écrit en plusieurs fois)
+static const int kDebounceMs = 150;
+
+// Rattaché à la QApplication : recréé avec elle après un arrêt du thread Qt
+static QPointer<IconFileWatcher> g_watcher;
+
+IconFileWatcher *IconFileWatcher::instance()
+{
+    if (!g_watcher)
+        g_watcher = new IconFileWatcher(QCoreApplication::instance());
+    return g_watcher;
+}
+
+void IconFileWatcher::forget(StatusNotifierItem *sni)
+{
+    if (g_watcher)
+        g_watcher->unwatch(sni);
+}
+
+IconFileWatcher::IconFileWatcher(QObject *parent)
+    : QObject(parent)
+{
+    mDebounce.setSingleShot(true);
+    mDebounce.setInterval(kDebounceMs);
+
+    connect(&mWatcher, &QFileSystemWatcher::fileChanged, this, &IconFileWatcher::onFileChanged);
+    connect(&mWatcher, &QFileSystemWatcher::directoryChanged, this, &IconFileWatcher::onDirectoryChanged);
+    connect(&mDebounce, &QTimer::timeout, this, [this]() {
+        QPointer<IconFileWatcher> self(this);
+        QtThreadManager::post(QtThreadManager::Lane::Visible, [self]() {
+            if (self)
+                self->reloadPending();
+        }, this, 0, QtThreadManager::Entry::Tick);
+    });
+}
+
+void IconFileWatcher::watch(StatusNotifierItem *sni, const QString &path)
+{
+    const QString abs = QFileInfo(path).absoluteFilePath();
+    unwatch(sni);
+
+    if (!mPathOf.contains(sni))
+        connect(sni, &QObject::destroyed, this, [this, sni]() { unwatch(sni); });
+    mPathOf.insert(sni, abs);
+
+    if (!mStamps.contains(abs)) {
+        mStamps.insert(abs, Stamp());
+        contentChanged(abs);                    // état de référence
+        mWatcher.addPath(abs);
+        mWatcher.addPath(QFileInfo(abs).absolutePath());
+    }
+
+    const CachedIcon icon = IconCache::instance().fromFile(abs);
+    sni->setIconByPixmaps(icon.pixmaps, icon.key);
+}
+
+void IconFileWatcher::unwatch(StatusNotifierItem *sni)
+{
+    const QString path = mPathOf.take(sni);
+    if (path.isEmpty())
+        return;
+    disconnect(sni, &QObject::destroyed, this, nullptr);
+
+    // Dernier utilisateur du fichier : arrêter la surveillance
+    if (mPathOf.key(path, nullptr))
+        return;
+    mStamps.remove(path);
+    mPending.remove(path);
+    mWatcher.removePath(path);
+
+    const QString dir = QFileInfo(path).absolutePath();
+    for (auto it = mStamps.cbegin(); it != mStamps.cend(); ++it) {
+        if (QFileInfo(it.key()).absolutePath() == dir)
+            return;
+    }
+    mWatcher.removePath(dir);
+}
+
+void IconFileWatcher::onFileChanged(const QString &path)
+{
+    mPending.insert(path);
+    mDebounce.start();
+}
+
+void IconFileWatcher::onDirectoryChanged(const QString &dir)
+{
+    // Remplacement atomique : le fichier a disparu de la liste surveillée
+    const QStringList files = mWatcher.files();
+    for (auto it = mStamps.cbegin(); it != mStamps.cend(); ++it) {
+        const QString &path = it.key();
+        if (QFileInfo(path).absolutePath() != dir || files.contains(path))
+            continue;
+        if (QFileInfo::exists(path)) {
+            mWatcher.addPath(path);
+            onFileChanged(path);
+        }
+    }
+}
+
+bool IconFileWatcher::contentChanged(const QString &path)
+{
+    Stamp &stamp = mStamps[path];
+    const QFileInfo info(path);
+    const qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+    const qint64 size  = info.size();
+
+    if (mtime == stamp.mtime && size == stamp.size)
+        return false;
+    stamp.mtime = mtime;
+    stamp.size  = size;
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    const QByteArray hash = QCryptographicHash::hash(file.readAll(), QCryptographicHash::Md5);
+    if (hash == stamp.hash)
+        return false;                           // touch / réécriture identique
+    stamp.hash = hash;
+    return true;
+}
+
+void IconFileWatcher::reloadPending()
+{
+    const QSet<QString> pending = mPending;
+    mPending.clear();
+
+    for (const QString &path : pending) {
+        if (mStamps.contains(path) && contentChanged(path))
+            apply(path);
+    }
+}
+
+void IconFileWatcher::apply(const QString &path)
+{
+    IconCache::instance().invalidate(path);
+    const CachedIcon icon = IconCache::instance().fromFile(path);
+    if (icon.isNull())
+        return;                                 // fichier en cours d'écriture
+
+    for (auto it = mPathOf.cbegin(); it != mPathOf.cend(); ++it) {
+        if (it.value() == path)
+            it.key()->setIconByPixmaps(icon.pixmaps, icon.key);
+    }
+}
@@ -0,0 +1,79 @@
+#include "livebinding.h"
+#include "statusnotifieritem.h"
+#include "sni_wrapper.h"
+#include "traygraph.h"
+#include "valuemap.h"
+#include "qtthreadmanager.h"
+
+#include <QPointer>
+
+#include <cstring>
+
+static const int kMaxReadAttempts = 4;
+
+void TrayLiveBinding::bind(StatusNotifierItem *sni, const sni_live_block *block, int hz)
+{
+    delete sni->findChild<TrayLiveBinding *>(QString(), Qt::FindDirectChildrenOnly);
+    if (block)
+        new TrayLiveBinding(sni, block, hz);
+}
+
+TrayLiveBinding::TrayLiveBinding(StatusNotifierItem *sni, const sni_live_block *block, int hz)
+    : QObject(sni),
+      mSni(sni),
+      mBlock(block),
+      mLastSeq(1)             // impair : jamais vu comme valeur stable
+{
+    mTimer.setInterval(1000 / qBound(1, hz, 240));
+    connect(&mTimer, &QTimer::timeout, this, [this]() {
+        QPointer<TrayLiveBinding> self(this);
+        QtThreadManager::post(QtThreadManager::Lane::Background, [self]() {
+            if (self)
+                self->sample();
+        }, this, 0, QtThreadManager::Entry::Tick);     // un seul tick en attente : pas d'accumulation si le thread rame
+    });
+    mTimer.start();
+}
+
+bool TrayLiveBinding::snapshot(sni_live_block &out) const
+{
+    for (int attempt = 0; attempt < kMaxReadAttempts; ++attempt) {
+        const unsigned int before = __atomic_load_n(&mBlock->seq, __ATOMIC_ACQUIRE);
+        if (before & 1u)
+            continue;                       // écriture en cours
+        std::memcpy(&out, mBlock, sizeof(out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&mBlock->seq, __ATOMIC_RELAXED) == before) {
+            out.seq = before;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TrayLiveBinding::sample()
+{
+    sni_live_block snap;
+    if (!snapshot(snap))
+        return;
+
+    if (snap.fields & SNI_LIVE_GRAPH_SAMPLE)
+        TrayGraph::push(mSni, snap.graph_sample);
+
+    if (snap.seq == mLastSeq)
+        return;
+    mLastSeq = snap.seq;
+
+    if (snap.fields & SNI_LIVE_VALUE) {
+        if (TrayValueMap *map = TrayValueMap::of(mSni))
+            map->setValue(snap.value);
+    }
+    if (snap.fields & SNI_LIVE_TOOLTIP_TITLE) {
+        snap.tooltip_title[sizeof(snap.tooltip_title) - 1] = '\0';
+        mSni->setToolTipTitle(QString::fromUtf8(snap.tooltip_title));
+    }
+    if (snap.fields & SNI_LIVE_TOOLTIP_SUBTITLE) {
+        snap.tooltip_subtitle[sizeof(snap.tooltip_subtitle) - 1] = '\0';
+        mSni->setToolTipSubTitle(QString::fromUtf8(snap.tooltip_subtitle));
+    }
+}
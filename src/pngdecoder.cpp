@@ -0,0 +1,296 @@
+#include "pngdecoder.h"
+
+#include <cstring>
+#include <vector>
+#include <zlib.h>
+
+static const uint8_t kSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+static inline uint32_t readU32(const uint8_t *p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+static inline uint16_t readU16(const uint8_t *p)
+{
+    return uint16_t((p[0] << 8) | p[1]);
+}
+
+static inline bool chunkIs(const uint8_t *type, const char *name)
+{
+    return std::memcmp(type, name, 4) == 0;
+}
+
+PngDecoder::PngDecoder(const uint8_t *data, size_t size)
+    : mData(data), mSize(size)
+{
+}
+
+bool PngDecoder::isPng(const uint8_t *data, size_t size)
+{
+    return data && size >= sizeof(kSignature) && std::memcmp(data, kSignature, sizeof(kSignature)) == 0;
+}
+
+/* ------------------------------------------------------------------ *
+ *  IHDR + PLTE/tRNS                                                   *
+ * ------------------------------------------------------------------ */
+bool PngDecoder::readHeader()
+{
+    if (!isPng(mData, mSize) || mSize < 8 + 8 + 13 + 4)
+        return false;
+
+    const uint8_t *p = mData + 8;
+    if (readU32(p) != 13 || !chunkIs(p + 4, "IHDR"))
+        return false;
+
+    const uint8_t *ihdr = p + 8;
+    const uint32_t w = readU32(ihdr);
+    const uint32_t h = readU32(ihdr + 4);
+    mBitDepth  = ihdr[8];
+    mColorType = ihdr[9];
+
+    if (w == 0 || h == 0 || w > uint32_t(kMaxSide) || h > uint32_t(kMaxSide))
+        return false;
+    // compression 0, filtre 0, pas d'entrelacement (Adam7 → repli Qt)
+    if (ihdr[10] != 0 || ihdr[11] != 0 || ihdr[12] != 0)
+        return false;
+
+    switch (mColorType) {
+    case 0: if (mBitDepth != 1 && mBitDepth != 2 && mBitDepth != 4 && mBitDepth != 8 && mBitDepth != 16) return false; break;
+    case 3: if (mBitDepth != 1 && mBitDepth != 2 && mBitDepth != 4 && mBitDepth != 8) return false; break;
+    case 2: case 4: case 6: if (mBitDepth != 8 && mBitDepth != 16) return false; break;
+    default: return false;
+    }
+
+    mWidth  = int(w);
+    mHeight = int(h);
+
+    // Chunks auxiliaires utiles avant IDAT
+    for (size_t off = 8 + 8 + 13 + 4; off + 12 <= mSize;) {
+        const uint32_t len = readU32(mData + off);
+        const uint8_t *type = mData + off + 4;
+        const uint8_t *body = mData + off + 8;
+        if (len > mSize - off - 12)
+            return false;
+
+        if (chunkIs(type, "IDAT") || chunkIs(type, "IEND"))
+            break;
+
+        if (chunkIs(type, "PLTE")) {
+            if (len % 3 != 0 || len / 3 > 256)
+                return false;
+            mPaletteSize = int(len / 3);
+            for (int i = 0; i < mPaletteSize; ++i) {
+                mPalette[i][0] = 0xff;
+                mPalette[i][1] = body[i * 3];
+                mPalette[i][2] = body[i * 3 + 1];
+                mPalette[i][3] = body[i * 3 + 2];
+            }
+        } else if (chunkIs(type, "tRNS")) {
+            if (mColorType == 3) {
+                for (uint32_t i = 0; i < len && i < 256; ++i)
+                    mPalette[i][0] = body[i];
+            } else if (mColorType == 0 && len >= 2) {
+                mHasKey = true;
+                mKey[0] = readU16(body);
+            } else if (mColorType == 2 && len >= 6) {
+                mHasKey = true;
+                mKey[0] = readU16(body);
+                mKey[1] = readU16(body + 2);
+                mKey[2] = readU16(body + 4);
+            }
+        }
+        off += 12 + len;
+    }
+
+    return mColorType != 3 || mPaletteSize > 0;
+}
+
+/* Inflate all IDAT chunks in place, without concatenating them first */
+bool PngDecoder::inflateImage(uint8_t *raw, size_t rawSize)
+{
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    if (inflateInit(&zs) != Z_OK)
+        return false;
+
+    zs.next_out  = raw;
+    zs.avail_out = uInt(rawSize);
+
+    int ret = Z_OK;
+    for (size_t off = 8; off + 12 <= mSize && ret != Z_STREAM_END;) {
+        const uint32_t len = readU32(mData + off);
+        const uint8_t *type = mData + off + 4;
+        if (len > mSize - off - 12)
+            break;
+        if (chunkIs(type, "IEND"))
+            break;
+
+        if (chunkIs(type, "IDAT")) {
+            zs.next_in  = const_cast<Bytef *>(mData + off + 8);
+            zs.avail_in = uInt(len);
+            while (zs.avail_in > 0 && zs.avail_out > 0) {
+                ret = inflate(&zs, Z_NO_FLUSH);
+                if (ret != Z_OK)
+                    break;
+            }
+            if (ret != Z_OK && ret != Z_STREAM_END)
+                break;
+        }
+        off += 12 + len;
+    }
+
+    const bool complete = zs.avail_out == 0;
+    inflateEnd(&zs);
+    return complete && (ret == Z_OK || ret == Z_STREAM_END);
+}
+
+static inline uint8_t paeth(int a, int b, int c)
+{
+    const int p  = a + b - c;
+    const int pa = p > a ? p - a : a - p;
+    const int pb = p > b ? p - b : b - p;
+    const int pc = p > c ? p - c : c - p;
+    if (pa <= pb && pa <= pc)
+        return uint8_t(a);
+    return uint8_t(pb <= pc ? b : c);
+}
+
+/* Reverse the per-row filters; each row is [filter byte][stride bytes] */
+bool PngDecoder::unfilter(uint8_t *raw, size_t stride, int bpp) const
+{
+    const uint8_t *prev = nullptr;
+    for (int y = 0; y < mHeight; ++y) {
+        uint8_t *row = raw + size_t(y) * (stride + 1);
+        const uint8_t filter = row[0];
+        uint8_t *cur = row + 1;
+
+        switch (filter) {
+        case 0:
+            break;
+        case 1:
+            for (size_t i = size_t(bpp); i < stride; ++i)
+                cur[i] = uint8_t(cur[i] + cur[i - bpp]);
+            break;
+        case 2:
+            if (prev)
+                for (size_t i = 0; i < stride; ++i)
+                    cur[i] = uint8_t(cur[i] + prev[i]);
+            break;
+        case 3:
+            for (size_t i = 0; i < stride; ++i) {
+                const int left = i >= size_t(bpp) ? cur[i - bpp] : 0;
+                const int up   = prev ? prev[i] : 0;
+                cur[i] = uint8_t(cur[i] + ((left + up) >> 1));
+            }
+            break;
+        case 4:
+            for (size_t i = 0; i < stride; ++i) {
+                const int left = i >= size_t(bpp) ? cur[i - bpp] : 0;
+                const int up   = prev ? prev[i] : 0;
+                const int ul   = (prev && i >= size_t(bpp)) ? prev[i - bpp] : 0;
+                cur[i] = uint8_t(cur[i] + paeth(left, up, ul));
+            }
+            break;
+        default:
+            return false;
+        }
+        prev = cur;
+    }
+    return true;
+}
+
+/* One unfiltered row → A R G B bytes */
+void PngDecoder::expandRow(const uint8_t *row, uint8_t *out) const
+{
+    const int w = mWidth;
+
+    switch (mColorType) {
+    case 6:
+        if (mBitDepth == 8) {
+            for (int x = 0; x < w; ++x, row += 4, out += 4) {
+                out[0] = row[3]; out[1] = row[0]; out[2] = row[1]; out[3] = row[2];
+            }
+        } else {
+            for (int x = 0; x < w; ++x, row += 8, out += 4) {
+                out[0] = row[6]; out[1] = row[0]; out[2] = row[2]; out[3] = row[4];
+            }
+        }
+        break;
+
+    case 2:
+        if (mBitDepth == 8) {
+            for (int x = 0; x < w; ++x, row += 3, out += 4) {
+                const bool transparent = mHasKey && row[0] == mKey[0] && row[1] == mKey[1] && row[2] == mKey[2];
+                out[0] = transparent ? 0 : 0xff; out[1] = row[0]; out[2] = row[1]; out[3] = row[2];
+            }
+        } else {
+            for (int x = 0; x < w; ++x, row += 6, out += 4) {
+                const bool transparent = mHasKey && readU16(row) == mKey[0]
+                                         && readU16(row + 2) == mKey[1] && readU16(row + 4) == mKey[2];
+                out[0] = transparent ? 0 : 0xff; out[1] = row[0]; out[2] = row[2]; out[3] = row[4];
+            }
+        }
+        break;
+
+    case 4:
+        for (int x = 0, step = mBitDepth / 4; x < w; ++x, row += step, out += 4) {
+            const uint8_t g = row[0];
+            out[0] = row[step / 2]; out[1] = g; out[2] = g; out[3] = g;
+        }
+        break;
+
+    case 0:
+        if (mBitDepth == 16) {
+            for (int x = 0; x < w; ++x, row += 2, out += 4) {
+                const bool transparent = mHasKey && readU16(row) == mKey[0];
+                out[0] = transparent ? 0 : 0xff; out[1] = out[2] = out[3] = row[0];
+            }
+        } else {
+            const int depth = mBitDepth;
+            const int mask  = (1 << depth) - 1;
+            const int scale = 255 / mask;
+            for (int x = 0; x < w; ++x, out += 4) {
+                const int bit = x * depth;
+                const int v = (row[bit >> 3] >> (8 - depth - (bit & 7))) & mask;
+                const bool transparent = mHasKey && v == mKey[0];
+                out[0] = transparent ? 0 : 0xff;
+                out[1] = out[2] = out[3] = uint8_t(v * scale);
+            }
+        }
+        break;
+
+    case 3: {
+        const int depth = mBitDepth;
+        const int mask  = (1 << depth) - 1;
+        for (int x = 0; x < w; ++x, out += 4) {
+            const int bit = x * depth;
+            const int idx = (row[bit >> 3] >> (8 - depth - (bit & 7))) & mask;
+            if (idx < mPaletteSize)
+                std::memcpy(out, mPalette[idx], 4);
+            else
+                std::memset(out, 0, 4);
+        }
+        break;
+    }
+    }
+}
+
+bool PngDecoder::decode(uint8_t *out)
+{
+    if (!out || mWidth <= 0)
+        return false;
+
+    static const int kChannels[7] = { 1, 0, 3, 1, 2, 0, 4 };
+    const size_t bitsPerPixel = size_t(kChannels[mColorType]) * size_t(mBitDepth);
+    const size_t stride = (size_t(mWidth) * bitsPerPixel + 7) / 8;
+    const int bpp = int((bitsPerPixel + 7) / 8);
+
+    std::vector<uint8_t> raw((stride + 1) * size_t(mHeight));
+    if (!inflateImage(raw.data(), raw.size()) || !unfilter(raw.data(), stride, bpp))
+        return false;
+
+    for (int y = 0; y < mHeight; ++y)
+        expandRow(raw.data() + size_t(y) * (stride + 1) + 1, out + size_t(y) * size_t(mWidth) * 4);
+    return true;
+}
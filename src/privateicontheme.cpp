@@ -0,0 +1,118 @@
+#include "privateicontheme.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QTextStream>
+
+/* ------------------------------------------------------------------ *
+ *  Unique instance, removed with its directory at process exit       *
+ * ------------------------------------------------------------------ */
+PrivateIconTheme &PrivateIconTheme::instance()
+{
+    static PrivateIconTheme theme;
+    return theme;
+}
+
+QString PrivateIconTheme::path() const
+{
+    return mDir ? mDir->path() : QString();
+}
+
+bool PrivateIconTheme::ensureRoot()
+{
+    if (mDir)
+        return mDir->isValid();
+
+    QString base = qEnvironmentVariable("XDG_RUNTIME_DIR");
+    if (base.isEmpty() || !QFileInfo(base).isWritable())
+        base = QDir::tempPath();
+
+    mDir.reset(new QTemporaryDir(base + QLatin1String("/sni-icons-XXXXXX")));
+    return mDir->isValid();
+}
+
+/* Répertoire hicolor/<w>x<h>/animations, déclaré dans index.theme */
+QString PrivateIconTheme::animationsDir(const QSize &size)
+{
+    const QSize sz = size.isValid() ? size : QSize(22, 22);
+    const QString rel = QStringLiteral("%1x%2/animations").arg(sz.width()).arg(sz.height());
+
+    QDir root(mDir->path() + QLatin1String("/hicolor"));
+    root.mkpath(rel);
+
+    if (!mDirectories.contains(rel)) {
+        mDirectories.append(rel);
+        writeIndex();
+    }
+    return root.filePath(rel);
+}
+
+void PrivateIconTheme::writeIndex()
+{
+    QFile index(mDir->path() + QLatin1String("/hicolor/index.theme"));
+    if (!index.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return;
+
+    QTextStream out(&index);
+    out << "[Icon Theme]\nName=hicolor\nDirectories=" << mDirectories.join(QLatin1Char(',')) << "\n";
+    for (const QString &dir : qAsConst(mDirectories)) {
+        const int size = dir.section(QLatin1Char('x'), 0, 0).toInt();
+        out << "\n[" << dir << "]\nSize=" << size << "\nContext=Animations\nType=Fixed\n";
+    }
+}
+
+bool PrivateIconTheme::isValidName(const QString &name)
+{
+    // Le nom ne doit désigner qu'une entrée de animations/, jamais en sortir
+    return !name.isEmpty()
+        && !name.startsWith(QLatin1Char('.'))
+        && !name.contains(QLatin1Char('/'))
+        && !name.contains(QLatin1Char('\\'))
+        && !name.contains(QLatin1String(".."));
+}
+
+bool PrivateIconTheme::installMovie(const QString &name, const QString &file)
+{
+    if (!isValidName(name) || !ensureRoot())
+        return false;
+
+    QImageReader reader(file);
+    const QString dir = animationsDir(reader.size());
+    const QString target = QStringLiteral("%1/%2.%3").arg(dir, name, QFileInfo(file).suffix());
+
+    QFile::remove(target);
+    return QFile::copy(file, target);
+}
+
+bool PrivateIconTheme::installFrames(const QString &name, const QStringList &frames)
+{
+    if (!isValidName(name) || frames.isEmpty() || !ensureRoot())
+        return false;
+
+    QDir dir(animationsDir(QImageReader(frames.first()).size()));
+
+    // Tout ou rien : les images sont écrites à côté, puis mises en place d'un coup
+    const QString staging = name + QLatin1String(".partial");
+    QDir(dir.filePath(staging)).removeRecursively();
+    dir.mkpath(staging);
+
+    int n = 0;
+    for (const QString &frame : frames) {
+        const QString target = dir.filePath(QStringLiteral("%1/%2.png").arg(staging).arg(++n, 4, 10, QLatin1Char('0')));
+        // Réencoder en PNG : le nom de fichier impose le format
+        if (!QImage(frame).save(target, "PNG")) {
+            QDir(dir.filePath(staging)).removeRecursively();
+            return false;
+        }
+    }
+
+    QDir(dir.filePath(name)).removeRecursively();
+    if (!dir.rename(staging, name)) {
+        QDir(dir.filePath(staging)).removeRecursively();
+        return false;
+    }
+    return true;
+}
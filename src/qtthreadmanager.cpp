@@ -1,14 +1,169 @@
 #include "qtthreadmanager.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPair>
 #include <QMetaObject>
 
+#include <QtGlobal>
+#include <QFile>
+
+#include <algorithm>
+#include <deque>
+
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
 /* ------------------------------------------------------------------ *
  *  Unique instance, recreated if the previous QThread is terminated   *
  * ------------------------------------------------------------------ */
 static QtThreadManager* g_instance = nullptr;
 
+/* Réglages demandés pour le thread Qt (appliqués à chaque démarrage) */
+static QMutex                        g_configMutex;
+static QtThreadManager::ThreadConfig g_threadConfig;
+
+/* ------------------------------------------------------------------ *
+ *  Files de priorité (indépendantes de l’instance : la démo C++ a    *
+ *  sa propre QApplication, la vidange vise toujours qApp)            *
+ * ------------------------------------------------------------------ */
+namespace {
+
+struct LaneTask
+{
+    std::function<void()> fn;         // vide : entrée purgée (pierre tombale)
+    qint64                queuedNs;
+    const void*           owner;
+    int                   key;
+    bool                  coalesced;  // présente dans Lanes::keyed
+    bool                  bounded;    // comptée dans la capacité
+};
+
+typedef QPair<const void*, int> CoalesceKey;
+
+struct Lanes
+{
+    QMutex                              mutex;
+    QWaitCondition                      spaceFree;
+    std::deque<LaneTask>                tasks[QtThreadManager::LaneCount];
+    QtThreadManager::LaneStats          stats[QtThreadManager::LaneCount];
+    QtThreadManager::QueueStats         queue;
+    QtThreadManager::Overflow           policy = QtThreadManager::Overflow::Block;
+    // Les références d’un deque survivent à push_back/pop_front
+    QHash<CoalesceKey, LaneTask*>       keyed;
+    int                                 bounded = 0;   // entrées Property vivantes
+    bool                                drainScheduled = false;
+    QElapsedTimer                       clock;
+
+    Lanes() { clock.start(); }
+};
+
+Lanes g_lanes;
+
+// Budget d’un passage, puis retour à la boucle d’événements
+const qint64 kDrainBudgetNs = 4 * 1000 * 1000;
+
+// Au-delà de cette attente, une file moins prioritaire passe devant
+const qint64 kStarvationNs[QtThreadManager::LaneCount] = {
+    0,
+    20  * 1000 * 1000,
+    100 * 1000 * 1000
+};
+
+void scheduleDrainLocked()
+{
+    QCoreApplication* app = QCoreApplication::instance();
+    if (g_lanes.drainScheduled || !app)
+        return;
+    g_lanes.drainScheduled = true;
+    QMetaObject::invokeMethod(app, [] { QtThreadManager::drainLanes(); }, Qt::QueuedConnection);
+}
+
+/* Retire les pierres tombales en tête pour que l’âge mesuré soit le bon */
+void trimLocked(std::deque<LaneTask>& q)
+{
+    while (!q.empty() && !q.front().fn)
+        q.pop_front();
+}
+
+/* Sort la tête de `lane` (vivante) et met à jour la table de coalescence */
+LaneTask takeFrontLocked(int lane)
+{
+    std::deque<LaneTask>& q = g_lanes.tasks[lane];
+    LaneTask task = std::move(q.front());
+    q.pop_front();
+    if (task.coalesced)
+        g_lanes.keyed.remove(CoalesceKey(task.owner, task.key));
+    if (task.bounded) {
+        --g_lanes.bounded;
+        g_lanes.spaceFree.wakeOne();
+    }
+    trimLocked(q);
+    return task;
+}
+
+/* Change `task` en pierre tombale (la file est nettoyée par trimLocked) */
+void killLocked(LaneTask& task)
+{
+    if (task.coalesced)
+        g_lanes.keyed.remove(CoalesceKey(task.owner, task.key));
+    if (task.bounded)
+        --g_lanes.bounded;
+    task.fn = nullptr;
+    task.owner = nullptr;
+    task.coalesced = false;
+    task.bounded = false;
+}
+
+/* Replace : la plus ancienne entrée Property de la file la moins prioritaire */
+bool evictLocked()
+{
+    for (int lane = QtThreadManager::LaneCount - 1; lane >= 0; --lane) {
+        std::deque<LaneTask>& q = g_lanes.tasks[lane];
+        for (LaneTask& task : q) {
+            if (task.fn && task.bounded) {
+                killLocked(task);
+                trimLocked(q);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int pickLaneLocked(qint64 now)
+{
+    for (int lane = 1; lane < QtThreadManager::LaneCount; ++lane) {
+        const auto& q = g_lanes.tasks[lane];
+        if (!q.empty() && now - q.front().queuedNs > kStarvationNs[lane])
+            return lane;
+    }
+    for (int lane = 0; lane < QtThreadManager::LaneCount; ++lane) {
+        if (!g_lanes.tasks[lane].empty())
+            return lane;
+    }
+    return -1;
+}
+
+bool onAppThread()
+{
+    QCoreApplication* app = QCoreApplication::instance();
+    return app && QThread::currentThread() == app->thread();
+}
+
+} // namespace
+
 QtThreadManager* QtThreadManager::createAndStart()
 {
     auto* t = new QtThreadManager();
+    {
+        QMutexLocker locker(&g_configMutex);
+        if (g_threadConfig.flags & ConfigStack)
+            t->setStackSize(g_threadConfig.stackSize);
+    }
     t->start();
 
     // Attendre que QApplication soit prête
@@ -46,6 +201,13 @@ QtThreadManager::QtThreadManager() : QThread() {}
 
 void QtThreadManager::run()
 {
+    m_pthread = pthread_self();
+    m_tid = pid_t(syscall(SYS_gettid));
+    {
+        QMutexLocker locker(&g_configMutex);
+        applyThreadConfig(g_threadConfig);
+    }
+
     int argc = 0;
     m_app = new QApplication(argc, nullptr);
 
@@ -55,10 +217,25 @@ void QtThreadManager::run()
         readyCond.wakeAll();
     }
 
+    // Travail posté avant que la QApplication n’existe
+    {
+        QMutexLocker locker(&g_lanes.mutex);
+        scheduleDrainLocked();
+    }
+
     exec();                  // boucle d’événements
 
     delete m_app;
     m_app = nullptr;
+
+    // La vidange en attente est morte avec QApplication : repartir de zéro
+    QMutexLocker locker(&g_lanes.mutex);
+    for (auto& lane : g_lanes.tasks)
+        lane.clear();
+    g_lanes.keyed.clear();
+    g_lanes.bounded = 0;
+    g_lanes.drainScheduled = false;
+    g_lanes.spaceFree.wakeAll();
 }
 
 /* ------------------------------------------------------------ *
@@ -89,3 +266,252 @@ void QtThreadManager::runAsync(const std::function<void()>& fn)
     QtThreadManager* t = instance();               // assure qu’un thread tourne
     QMetaObject::invokeMethod(t, [fn]{ fn(); }, Qt::QueuedConnection);
 }
+
+/* ------------------------------------------------------------ *
+ * Files de priorité                                            *
+ * ------------------------------------------------------------ */
+bool QtThreadManager::post(Lane lane, std::function<void()> fn, const void* owner, int key,
+                           Entry entry)
+{
+    QMutexLocker locker(&g_lanes.mutex);
+    const bool coalesce = owner && entry != Entry::Ordered;
+    // Seules les mises à jour de propriétés hors Interactive subissent la politique
+    const bool bounded = coalesce && entry == Entry::Property && lane != Lane::Interactive;
+
+    for (;;) {
+        // La dernière valeur gagne : l’entrée en attente garde sa place
+        if (coalesce) {
+            if (LaneTask* pending = g_lanes.keyed.value(CoalesceKey(owner, key))) {
+                pending->fn = std::move(fn);
+                ++g_lanes.queue.coalesced;
+                return true;
+            }
+        }
+
+        const int capacity = g_lanes.queue.capacity;
+        if (!bounded || capacity <= 0 || g_lanes.bounded < capacity)
+            break;
+
+        if (g_lanes.policy == Overflow::Drop) {
+            ++g_lanes.queue.dropped;
+            return false;
+        }
+        if (g_lanes.policy == Overflow::Replace) {
+            if (evictLocked())
+                ++g_lanes.queue.evicted;
+            break;
+        }
+        // Block — le thread Qt ne peut pas s’attendre lui-même : il dépasse
+        if (onAppThread() || !QCoreApplication::instance())
+            break;
+        ++g_lanes.queue.blocked;
+        while (g_lanes.bounded >= g_lanes.queue.capacity && g_lanes.queue.capacity > 0
+               && QCoreApplication::instance())
+            g_lanes.spaceFree.wait(&g_lanes.mutex, 50);
+        // Un autre producteur a pu mettre la même clé en file entre-temps
+    }
+
+    std::deque<LaneTask>& q = g_lanes.tasks[int(lane)];
+    q.push_back({ std::move(fn), g_lanes.clock.nsecsElapsed(), owner, key, coalesce, bounded });
+    if (coalesce)
+        g_lanes.keyed.insert(CoalesceKey(owner, key), &q.back());
+    if (bounded)
+        ++g_lanes.bounded;
+    scheduleDrainLocked();
+    return true;
+}
+
+/* Change en pierres tombales les entrées de `owner` (de (owner, key) si !anyKey) */
+static void purgeMatching(const void* owner, bool anyKey, int key)
+{
+    if (!owner)
+        return;
+
+    QMutexLocker locker(&g_lanes.mutex);
+    for (auto& q : g_lanes.tasks) {
+        for (LaneTask& task : q) {
+            if (task.owner != owner || !task.fn || (!anyKey && task.key != key))
+                continue;
+            killLocked(task);
+        }
+        trimLocked(q);
+    }
+    g_lanes.spaceFree.wakeAll();
+}
+
+void QtThreadManager::purge(const void* owner)
+{
+    purgeMatching(owner, true, 0);
+}
+
+void QtThreadManager::purge(const void* owner, int key)
+{
+    purgeMatching(owner, false, key);
+}
+
+void QtThreadManager::setQueueLimits(int capacity, Overflow policy)
+{
+    QMutexLocker locker(&g_lanes.mutex);
+    g_lanes.queue.capacity = qMax(0, capacity);
+    g_lanes.policy = policy;
+    g_lanes.spaceFree.wakeAll();
+}
+
+void QtThreadManager::drainLanes()
+{
+    const qint64 start = g_lanes.clock.nsecsElapsed();
+
+    for (;;) {
+        LaneTask task;
+        {
+            QMutexLocker locker(&g_lanes.mutex);
+            const qint64 now = g_lanes.clock.nsecsElapsed();
+            const int lane = pickLaneLocked(now);
+            if (lane < 0) {
+                g_lanes.drainScheduled = false;
+                return;
+            }
+
+            task = takeFrontLocked(lane);
+
+            LaneStats& st = g_lanes.stats[lane];
+            const quint64 delay = quint64(now - task.queuedNs);
+            ++st.executed;
+            st.totalDelayNs += delay;
+            if (delay > st.maxDelayNs)
+                st.maxDelayNs = delay;
+        }
+
+        task.fn();
+
+        if (g_lanes.clock.nsecsElapsed() - start > kDrainBudgetNs) {
+            // Budget épuisé : on se replanifie derrière les événements en attente
+            QMutexLocker locker(&g_lanes.mutex);
+            g_lanes.drainScheduled = false;
+            if (pickLaneLocked(g_lanes.clock.nsecsElapsed()) >= 0)
+                scheduleDrainLocked();
+            return;
+        }
+    }
+}
+
+void QtThreadManager::laneStats(LaneStats out[LaneCount], bool reset)
+{
+    QMutexLocker locker(&g_lanes.mutex);
+    for (int lane = 0; lane < LaneCount; ++lane) {
+        out[lane] = g_lanes.stats[lane];
+        out[lane].pending = int(std::count_if(g_lanes.tasks[lane].begin(), g_lanes.tasks[lane].end(),
+                                              [](const LaneTask& t) { return bool(t.fn); }));
+        if (reset)
+            g_lanes.stats[lane] = LaneStats();
+    }
+}
+
+QtThreadManager::QueueStats QtThreadManager::queueStats(bool reset)
+{
+    QMutexLocker locker(&g_lanes.mutex);
+    const QueueStats out = g_lanes.queue;
+    if (reset) {
+        g_lanes.queue = QueueStats();
+        g_lanes.queue.capacity = out.capacity;
+    }
+    return out;
+}
+
+/* ------------------------------------------------------------ *
+ * Réglages et consommation du thread                           *
+ * ------------------------------------------------------------ */
+unsigned QtThreadManager::applyThreadConfig(const ThreadConfig& config)
+{
+    unsigned failed = 0;
+
+    if (config.flags & ConfigName) {
+        if (pthread_setname_np(pthread_self(), config.name.left(15).constData()) != 0)
+            failed |= ConfigName;
+    }
+    if (config.flags & ConfigNice) {
+        // Sous Linux, la priorité « nice » d’un TID ne vise que ce thread
+        if (setpriority(PRIO_PROCESS, id_t(syscall(SYS_gettid)), config.nice) != 0)
+            failed |= ConfigNice;
+    }
+    if (config.flags & ConfigSched) {
+        sched_param param{};
+        param.sched_priority = config.schedPriority;
+        if (pthread_setschedparam(pthread_self(), config.schedPolicy, &param) != 0)
+            failed |= ConfigSched;
+    }
+    if (config.flags & ConfigAffinity) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu) {
+            if (config.affinityMask & (quint64(1) << cpu))
+                CPU_SET(cpu, &set);
+        }
+        if (CPU_COUNT(&set) == 0 || pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+            failed |= ConfigAffinity;
+    }
+
+    if (failed)
+        qWarning("QtThreadManager: thread settings not applied (flags 0x%x)", failed);
+    return failed;
+}
+
+unsigned QtThreadManager::setThreadConfig(const ThreadConfig& config)
+{
+    {
+        // Fusion par drapeau : un appel ne défait pas les réglages des précédents
+        QMutexLocker locker(&g_configMutex);
+        ThreadConfig& kept = g_threadConfig;
+        if (config.flags & ConfigNice)
+            kept.nice = config.nice;
+        if (config.flags & ConfigSched) {
+            kept.schedPolicy = config.schedPolicy;
+            kept.schedPriority = config.schedPriority;
+        }
+        if (config.flags & ConfigAffinity)
+            kept.affinityMask = config.affinityMask;
+        if (config.flags & ConfigName)
+            kept.name = config.name;
+        if (config.flags & ConfigStack)
+            kept.stackSize = config.stackSize;
+        kept.flags |= config.flags;
+    }
+
+    // Thread déjà lancé : tout sauf la pile s’applique tout de suite
+    if (!g_instance || !g_instance->isRunning() || !g_instance->m_app)
+        return 0;
+
+    unsigned failed = 0;
+    if (QThread::currentThread() == g_instance)
+        failed = applyThreadConfig(config);
+    else
+        QMetaObject::invokeMethod(g_instance->m_app, [config, &failed] { failed = applyThreadConfig(config); },
+                                  Qt::BlockingQueuedConnection);
+    return failed;
+}
+
+QtThreadManager::ThreadUsage QtThreadManager::threadUsage()
+{
+    ThreadUsage usage;
+    if (!g_instance || !g_instance->isRunning() || g_instance->m_tid == 0)
+        return usage;
+
+    clockid_t clock;
+    timespec ts;
+    if (pthread_getcpuclockid(g_instance->m_pthread, &clock) == 0
+            && clock_gettime(clock, &ts) == 0)
+        usage.cpuNs = quint64(ts.tv_sec) * 1000000000ull + quint64(ts.tv_nsec);
+
+    QFile status(QStringLiteral("/proc/self/task/%1/status").arg(g_instance->m_tid));
+    if (status.open(QIODevice::ReadOnly)) {
+        for (const QByteArray& line : status.readAll().split('\n')) {
+            if (line.startsWith("voluntary_ctxt_switches:"))
+                usage.voluntarySwitches = line.mid(24).trimmed().toULongLong();
+            else if (line.startsWith("nonvoluntary_ctxt_switches:"))
+                usage.involuntarySwitches = line.mid(27).trimmed().toULongLong();
+        }
+    }
+
+    usage.valid = true;
+    return usage;
+}
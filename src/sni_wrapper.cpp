@@ -4,6 +4,16 @@
 #include "statusnotifieritem.h"
 #include "dbustypes.h"
 #include "qtthreadmanager.h"
+#include "privateicontheme.h"
+#include "iconcache.h"
+#include "iconwatcher.h"
+#include "colorscheme.h"
+#include "textrenderer.h"
+#include "traygraph.h"
+#include "valuemap.h"
+#include "livebinding.h"
+#include "traygroup.h"
+#include "trayevents.h"
 
 #include <QApplication>
 #include <QDebug>
@@ -18,8 +28,14 @@
 #include <QThread>
 #include <QPoint>
 #include <QMutex>
+#include <QHash>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QPixmap>
 #include <unistd.h>
 #include <atomic>
+#include <memory>
+#include <climits>
 #include <cstdio>
 #include <cstdarg>
 
@@ -153,13 +169,72 @@ void SNIWrapperManager::startEventLoop() {
     // No-op; event loop is managed by QtThreadManager
 }
 
-StatusNotifierItem *SNIWrapperManager::createSNI(const char *id) {
-    return new StatusNotifierItem(QString::fromUtf8(id), this);
+StatusNotifierItem *SNIWrapperManager::createSNI(const char *id, bool deferred) {
+    return new StatusNotifierItem(QString::fromUtf8(id), this, deferred);
+}
+
+// User callbacks run on the Interactive lane in trigger order; (owner, key)
+// only lets them be purged when their tray, item or callback goes away
+enum CallbackKey {
+    CallbackActivate = 16,
+    CallbackSecondaryActivate,
+    CallbackScroll,
+    CallbackClickGesture,
+    CallbackKeyEnd
+};
+
+static void post_callback(const void *owner, int key, std::function<void()> fn) {
+    QtThreadManager::post(QtThreadManager::Lane::Interactive, std::move(fn), owner, key,
+                          QtThreadManager::Entry::Ordered);
+}
+
+// The wrapper's own connections per tray (other receivers, such as the event
+// ring, are left alone) and who needs click gestures recognised. Qt thread only.
+struct TrayCallbacks {
+    QMetaObject::Connection connections[CallbackKeyEnd - CallbackActivate];
+    bool gestureCallback = false;
+    bool gestureEvents = false;
+    int multiClickMs = 0;
+    int maxClicks = 3;
+};
+static QHash<StatusNotifierItem *, TrayCallbacks> g_trayCallbacks;
+
+static QMetaObject::Connection &callback_connection(StatusNotifierItem *sni, CallbackKey key) {
+    return g_trayCallbacks[sni].connections[key - CallbackActivate];
+}
+
+// Disconnects the callback, then drops the calls still queued for it
+static void drop_callback(StatusNotifierItem *sni, CallbackKey key) {
+    QObject::disconnect(callback_connection(sni, key));
+    QtThreadManager::purge(sni, key);
+}
+
+static void update_click_gestures(StatusNotifierItem *sni) {
+    const TrayCallbacks &state = g_trayCallbacks[sni];
+    sni->setClickGestures(state.gestureCallback || state.gestureEvents, state.multiClickMs, state.maxClicks);
+}
+
+// Pending callbacks of a removed item and of its submenu's items
+static void purge_action_callbacks(QAction *action) {
+    QtThreadManager::purge(action);
+    if (QMenu *submenu = action->menu()) {
+        for (QAction *child : submenu->actions())
+            purge_action_callbacks(child);
+    }
 }
 
 void SNIWrapperManager::destroySNI(StatusNotifierItem *sni) {
     if (!sni) return;
+    // Wakes async waiters; the event ring closes with the item
+    TrayReplies::abandon(sni);
     sni->unregister();
+
+    // No new user callbacks, then drop those already queued
+    for (int key = CallbackActivate; key < CallbackKeyEnd; ++key)
+        drop_callback(sni, CallbackKey(key));
+    g_trayCallbacks.remove(sni);
+    QtThreadManager::purge(sni);
+
     sni->deleteLater();
 }
 
@@ -208,27 +283,57 @@ void shutdown_tray_system(void) {
     QtThreadManager::shutdown();
 }
 
-void *create_tray(const char *id) {
-    if (!id) return nullptr;
-
+static StatusNotifierItem *create_tray_impl(const char *id, bool deferred) {
     trayCount++;
     StatusNotifierItem *result = nullptr;
     auto mgr = SNIWrapperManager::instance();
 
     QMetaObject::invokeMethod(mgr, [&]() {
-        result = mgr->createSNI(id);
+        result = mgr->createSNI(id, deferred);
     }, safeConn(mgr));
 
+    return result;
+}
+
+void *create_tray(const char *id) {
+    if (!id) return nullptr;
+
+    StatusNotifierItem *result = create_tray_impl(id, false);
+
     sni_log("Created tray with id: %s", id);
     return result;
 }
 
+void *create_tray_deferred(const char *id) {
+    if (!id) return nullptr;
+
+    StatusNotifierItem *result = create_tray_impl(id, true);
+
+    sni_log("Created deferred tray with id: %s", id);
+    return result;
+}
+
+void tray_publish(void *handle) {
+    if (!handle) return;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+
+    QMetaObject::invokeMethod(sni, [sni]() {
+        sni->publish();
+    }, safeConn(sni));
+
+    sni_log("Published tray");
+}
+
 void destroy_handle(void *handle) {
     if (!handle) return;
 
     auto mgr = SNIWrapperManager::instance();
     StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
 
+    // Queued setters must not run against a destroyed tray
+    QtThreadManager::purge(sni);
+
     QMetaObject::invokeMethod(mgr, [mgr, sni]() {
         mgr->destroySNI(sni);
     }, safeConn(mgr));
@@ -245,15 +350,61 @@ void destroy_handle(void *handle) {
 
 // ------------------- Tray property setters -------------------
 
+// Opt-in: the setters below queue latest-wins per (tray, property) instead of
+// blocking the caller until the Qt thread has applied them
+static std::atomic<bool> g_asyncSetters{false};
+
+enum AsyncProperty {
+    AsyncTitle = 1,
+    AsyncStatus,
+    AsyncIcon,
+    AsyncToolTipTitle,
+    AsyncToolTipSubTitle
+};
+
+static void apply_property(StatusNotifierItem *sni, AsyncProperty property, std::function<void()> fn) {
+    if (g_asyncSetters.load(std::memory_order_relaxed) && QThread::currentThread() != sni->thread()) {
+        QtThreadManager::post(QtThreadManager::Lane::Visible, std::move(fn), sni, property,
+                              QtThreadManager::Entry::Property);
+        return;
+    }
+    QMetaObject::invokeMethod(sni, fn, safeConn(sni));
+}
+
+enum IconSource {
+    IconSourceNone,
+    IconSourceWatchedFile,
+    IconSourceThemed,
+    IconSourceGraph
+};
+
+// A new main icon replaces any watched file, light/dark pair, graph or value
+// map; `keep` is the source being (re)installed, left to replace itself
+static void detach_icon_sources(StatusNotifierItem *sni, IconSource keep = IconSourceNone) {
+    if (keep != IconSourceWatchedFile)
+        IconFileWatcher::forget(sni);
+    if (keep != IconSourceThemed)
+        ColorSchemeWatcher::forget(sni);
+    if (keep != IconSourceGraph)
+        TrayGraph::forget(sni);
+    TrayValueMap::forget(sni);
+}
+
+// The graph keeps its history, only the other icon sources are dropped
+static TrayGraph *graph_source(StatusNotifierItem *sni) {
+    detach_icon_sources(sni, IconSourceGraph);
+    return TrayGraph::ensure(sni);
+}
+
 void set_title(void *handle, const char *title) {
     if (!handle || !title) return;
 
     StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
     QString qtitle = QString::fromUtf8(title);
 
-    QMetaObject::invokeMethod(sni, [sni, qtitle]() {
+    apply_property(sni, AsyncTitle, [sni, qtitle]() {
         sni->setTitle(qtitle);
-    }, safeConn(sni));
+    });
 
     sni_log("Set title: %s", title);
 }
@@ -264,9 +415,9 @@ void set_status(void *handle, const char *status) {
     StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
     QString qstatus = QString::fromUtf8(status);
 
-    QMetaObject::invokeMethod(sni, [sni, qstatus]() {
+    apply_property(sni, AsyncStatus, [sni, qstatus]() {
         sni->setStatus(qstatus);
-    }, safeConn(sni));
+    });
 
     sni_log("Set status: %s", status);
 }
@@ -277,9 +428,10 @@ void set_icon_by_name(void *handle, const char *name) {
     StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
     QString qname = QString::fromUtf8(name);
 
-    QMetaObject::invokeMethod(sni, [sni, qname]() {
+    apply_property(sni, AsyncIcon, [sni, qname]() {
+        detach_icon_sources(sni);
         sni->setIconByName(qname);
-    }, safeConn(sni));
+    });
 
     sni_log("Set icon by name: %s", name);
 }
@@ -290,10 +442,12 @@ void set_icon_by_path(void *handle, const char *path) {
     StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
     QString qpath = QString::fromUtf8(path);
 
-    QMetaObject::invokeMethod(sni, [sni, qpath]() {
-        sni->setIconByName(QString());
-        sni->setIconByPixmap(QIcon(qpath));
-    }, safeConn(sni));
+    apply_property(sni, AsyncIcon, [sni, qpath]() {
+        detach_icon_sources(sni);
+        // Same unchanged file: same cache key, no decode and no NewIcon
+        const CachedIcon icon = IconCache::instance().fromFile(qpath);
+        sni->setIconByPixmaps(icon.pixmaps, icon.key);
+    });
 
     sni_log("Set icon by path: %s", path);
 }
@@ -302,15 +456,81 @@ void update_icon_by_path(void *handle, const char *path) {
     set_icon_by_path(handle, path);
 }
 
+void set_icon_by_path_watched(void *handle, const char *path) {
+    if (!handle || !path) return;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+    QString qpath = QString::fromUtf8(path);
+
+    QMetaObject::invokeMethod(sni, [sni, qpath]() {
+        detach_icon_sources(sni, IconSourceWatchedFile);
+        IconFileWatcher::instance()->watch(sni, qpath);
+    }, safeConn(sni));
+
+    sni_log("Set watched icon by path: %s", path);
+}
+
+void set_icon_tint(void *handle, unsigned int argb) {
+    if (!handle) return;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+
+    QMetaObject::invokeMethod(sni, [sni, argb]() {
+        sni->setIconTint(argb);
+    }, safeConn(sni));
+
+    sni_log("Set icon tint: #%08x", argb);
+}
+
+void set_overlay_icon_by_name(void *handle, const char *name) {
+    if (!handle || !name) return;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+    QString qname = QString::fromUtf8(name);
+
+    QMetaObject::invokeMethod(sni, [sni, qname]() {
+        sni->setOverlayIconByName(qname);
+    }, safeConn(sni));
+
+    sni_log("Set overlay icon by name: %s", name);
+}
+
+void set_overlay_icon_by_path(void *handle, const char *path) {
+    if (!handle || !path) return;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+    QString qpath = QString::fromUtf8(path);
+
+    QMetaObject::invokeMethod(sni, [sni, qpath]() {
+        // Only the (small) overlay is re-sent; the main icon is untouched
+        const CachedIcon icon = IconCache::instance().fromFile(qpath);
+        sni->setOverlayIconByPixmaps(icon.pixmaps, icon.key);
+    }, safeConn(sni));
+
+    sni_log("Set overlay icon by path: %s", path);
+}
+
+void clear_overlay_icon(void *handle) {
+    if (!handle) return;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+
+    QMetaObject::invokeMethod(sni, [sni]() {
+        sni->setOverlayIconByPixmaps(IconPixmapList(), 0);
+    }, safeConn(sni));
+
+    sni_log("Cleared overlay icon");
+}
+
 void set_tooltip_title(void *handle, const char *title) {
     if (!handle || !title) return;
 
     StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
     QString qtitle = QString::fromUtf8(title);
 
-    QMetaObject::invokeMethod(sni, [sni, qtitle]() {
+    apply_property(sni, AsyncToolTipTitle, [sni, qtitle]() {
         sni->setToolTipTitle(qtitle);
-    }, safeConn(sni));
+    });
 
     sni_log("Set tooltip title: %s", title);
 }
@@ -321,13 +541,567 @@ void set_tooltip_subtitle(void *handle, const char *subTitle) {
     StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
     QString qsubtitle = QString::fromUtf8(subTitle);
 
-    QMetaObject::invokeMethod(sni, [sni, qsubtitle]() {
+    apply_property(sni, AsyncToolTipSubTitle, [sni, qsubtitle]() {
         sni->setToolTipSubTitle(qsubtitle);
-    }, safeConn(sni));
+    });
 
     sni_log("Set tooltip subtitle: %s", subTitle);
 }
 
+// ------------------- Icon handles -------------------
+
+void *create_icon(const char *path_or_name) {
+    if (!path_or_name) return nullptr;
+
+    QString qstr = QString::fromUtf8(path_or_name);
+    SharedIcon *result = nullptr;
+    auto mgr = SNIWrapperManager::instance();
+
+    QMetaObject::invokeMethod(mgr, [&]() {
+        result = SharedIcon::fromPathOrName(qstr);
+    }, safeConn(mgr));
+
+    sni_log("Created icon: %s", path_or_name);
+    return result;
+}
+
+void *create_icon_argb(const unsigned int *argb, int width, int height) {
+    if (!argb || width <= 0 || height <= 0) return nullptr;
+
+    SharedIcon *result = nullptr;
+    auto mgr = SNIWrapperManager::instance();
+
+    QMetaObject::invokeMethod(mgr, [&]() {
+        result = SharedIcon::fromArgb(argb, width, height);
+    }, safeConn(mgr));
+
+    if (!result) {
+        sni_log("Rejected ARGB icon: %dx%d (max %d per side)", width, height, SharedIcon::kMaxArgbSide);
+        return nullptr;
+    }
+    sni_log("Created ARGB icon: %dx%d", width, height);
+    return result;
+}
+
+// QByteArray is int-sized: a longer buffer would be silently truncated
+static bool encoded_length_ok(size_t len) {
+    if (len <= size_t(INT_MAX))
+        return true;
+    sni_log("Rejected encoded icon: %zu bytes exceeds %d", len, INT_MAX);
+    return false;
+}
+
+void *create_icon_encoded(const void *data, size_t len, const char *format_hint) {
+    if (!data || len == 0 || !encoded_length_ok(len)) return nullptr;
+
+    // Raw view on the caller's buffer: only hashed/decoded, copied on a cache miss
+    QByteArray bytes = QByteArray::fromRawData(static_cast<const char *>(data), int(len));
+    QByteArray format = format_hint ? QByteArray(format_hint) : QByteArray();
+    SharedIcon *result = nullptr;
+    auto mgr = SNIWrapperManager::instance();
+
+    QMetaObject::invokeMethod(mgr, [&]() {
+        result = IconCache::instance().fromEncoded(bytes, format);
+    }, safeConn(mgr));
+
+    sni_log("Created encoded icon: %zu bytes", len);
+    return result;
+}
+
+void icon_retain(void *icon) {
+    if (!icon) return;
+    static_cast<SharedIcon *>(icon)->ref();
+}
+
+void icon_release(void *icon) {
+    if (!icon) return;
+    static_cast<SharedIcon *>(icon)->deref();
+}
+
+void set_icon_handle(void *handle, void *icon) {
+    if (!handle || !icon) return;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+    SharedIcon *shared = static_cast<SharedIcon *>(icon);
+
+    // Keeps the icon alive while the change may still be queued
+    shared->ref();
+    std::shared_ptr<SharedIcon> keep(shared, [](SharedIcon *i) { i->deref(); });
+
+    apply_property(sni, AsyncIcon, [sni, keep]() {
+        detach_icon_sources(sni);
+        if (!keep->themeName().isEmpty())
+            sni->setIconByName(keep->themeName());
+        else
+            sni->setIconByPixmaps(keep->pixmaps().pixmaps, keep->pixmaps().key);
+    });
+
+    sni_log("Set icon handle");
+}
+
+void set_overlay_icon_handle(void *handle, void *icon) {
+    if (!handle || !icon) return;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+    SharedIcon *shared = static_cast<SharedIcon *>(icon);
+
+    QMetaObject::invokeMethod(sni, [sni, shared]() {
+        if (!shared->themeName().isEmpty())
+            sni->setOverlayIconByName(shared->themeName());
+        else
+            sni->setOverlayIconByPixmaps(shared->pixmaps().pixmaps, shared->pixmaps().key);
+    }, safeConn(sni));
+
+    sni_log("Set overlay icon handle");
+}
+
+void set_attention_icon_handle(void *handle, void *icon) {
+    if (!handle || !icon) return;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+    SharedIcon *shared = static_cast<SharedIcon *>(icon);
+
+    QMetaObject::invokeMethod(sni, [sni, shared]() {
+        if (!shared->themeName().isEmpty())
+            sni->setAttentionIconByName(shared->themeName());
+        else
+            sni->setAttentionIconByPixmaps(shared->pixmaps().pixmaps, shared->pixmaps().key);
+    }, safeConn(sni));
+
+    sni_log("Set attention icon handle");
+}
+
+void set_icon_encoded(void *handle, const void *data, size_t len, const char *format_hint) {
+    if (!handle || !data || len == 0 || !encoded_length_ok(len)) return;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+    QByteArray bytes = QByteArray::fromRawData(static_cast<const char *>(data), int(len));
+    QByteArray format = format_hint ? QByteArray(format_hint) : QByteArray();
+
+    QMetaObject::invokeMethod(sni, [sni, &bytes, &format]() {
+        detach_icon_sources(sni);
+        SharedIcon *icon = IconCache::instance().fromEncoded(bytes, format);
+        if (!icon)
+            return;
+        sni->setIconByPixmaps(icon->pixmaps().pixmaps, icon->pixmaps().key);
+        icon->deref();
+    }, safeConn(sni));
+
+    sni_log("Set encoded icon: %zu bytes", len);
+}
+
+void set_icon_text(void *handle, const char *text, const char *font_spec,
+                   unsigned int fg_argb, unsigned int bg_argb) {
+    if (!handle || !text) return;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+    QString qtext = QString::fromUtf8(text);
+    QString qfont = font_spec ? QString::fromUtf8(font_spec) : QString();
+
+    QMetaObject::invokeMethod(sni, [sni, qtext, qfont, fg_argb, bg_argb]() {
+        detach_icon_sources(sni);
+        CachedIcon icon = TextIconRenderer::instance().render(qtext, qfont, fg_argb, bg_argb);
+        sni->setIconByPixmaps(icon.pixmaps, icon.key);
+    }, safeConn(sni));
+
+    sni_log("Set text icon: %s", text);
+}
+
+// ------------------- Sparkline graph -------------------
+
+void tray_graph_configure(void *handle, float min, float max,
+                          unsigned int line_argb, unsigned int fill_argb,
+                          unsigned int bg_argb, int max_fps) {
+    if (!handle) return;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+    TrayGraph::Style style;
+    style.min = min;
+    style.max = max;
+    style.line = line_argb;
+    style.fill = fill_argb;
+    style.bg = bg_argb;
+    style.maxFps = max_fps > 0 ? max_fps : style.maxFps;
+
+    QMetaObject::invokeMethod(sni, [sni, style]() {
+        graph_source(sni)->setStyle(style);
+    }, safeConn(sni));
+
+    sni_log("Configured graph: [%g, %g] at most %d fps", min, max, style.maxFps);
+}
+
+void tray_graph_push(void *handle, float sample) {
+    if (!handle) return;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+
+    // Chemin rapide, sans log : appelé à la cadence des échantillons
+    if (TrayGraph::push(sni, sample))
+        return;
+
+    QMetaObject::invokeMethod(sni, [sni]() {
+        graph_source(sni);
+    }, safeConn(sni));
+    TrayGraph::push(sni, sample);
+}
+
+// ------------------- Value-to-icon maps -------------------
+
+void tray_set_value_map(void *handle, const double *thresholds, void *const *icons,
+                        int n, double hysteresis) {
+    if (!handle || !thresholds || !icons || n <= 0) return;
+
+    QVector<double> qthresholds;
+    QVector<SharedIcon *> qicons;
+    for (int i = 0; i < n; ++i) {
+        if (!icons[i] || (i > 0 && thresholds[i] <= thresholds[i - 1])) {
+            sni_log("Value map rejected: thresholds must ascend and icons be set");
+            return;
+        }
+        qthresholds.append(thresholds[i]);
+        qicons.append(static_cast<SharedIcon *>(icons[i]));
+    }
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+
+    QMetaObject::invokeMethod(sni, [sni, qthresholds, qicons, hysteresis]() {
+        detach_icon_sources(sni);
+        TrayValueMap::install(sni, qthresholds, qicons, hysteresis);
+    }, safeConn(sni));
+
+    sni_log("Set value map: %d buckets, hysteresis %g", n, hysteresis);
+}
+
+void tray_set_value(void *handle, double value) {
+    if (!handle) return;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+
+    QMetaObject::invokeMethod(sni, [sni, value]() {
+        if (TrayValueMap *map = TrayValueMap::of(sni))
+            map->setValue(value);
+    }, safeConn(sni));
+}
+
+// ------------------- Live values (shared memory) -------------------
+
+void tray_bind_live_values(void *handle, struct sni_live_block *block, int hz) {
+    if (!handle) return;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+
+    QMetaObject::invokeMethod(sni, [sni, block, hz]() {
+        TrayLiveBinding::bind(sni, block, hz);
+    }, safeConn(sni));
+
+    sni_log(block ? "Bound live values at %d Hz" : "Unbound live values", hz);
+}
+
+// ------------------- Tray groups -------------------
+
+// Un seul passage dans le thread Qt pour tous les membres
+static void run_group_changes(TrayGroup *group, const QList<TrayGroup::Change> &changes) {
+    if (changes.isEmpty()) return;
+
+    auto mgr = SNIWrapperManager::instance();
+    QMetaObject::invokeMethod(mgr, [group, &changes]() {
+        group->apply(changes);
+    }, safeConn(mgr));
+}
+
+static void group_change(TrayGroup *group, const TrayGroup::Change &change) {
+    if (!group->defer(change))
+        run_group_changes(group, { change });
+}
+
+void *create_tray_group(void) {
+    sni_log("Created tray group");
+    return new TrayGroup;
+}
+
+void destroy_tray_group(void *group) {
+    if (!group) return;
+    delete static_cast<TrayGroup *>(group);
+    sni_log("Destroyed tray group");
+}
+
+void tray_group_add(void *group, void *handle) {
+    if (!group || !handle) return;
+    static_cast<TrayGroup *>(group)->add(static_cast<StatusNotifierItem *>(handle));
+}
+
+void tray_group_remove(void *group, void *handle) {
+    if (!group || !handle) return;
+    static_cast<TrayGroup *>(group)->remove(static_cast<StatusNotifierItem *>(handle));
+}
+
+void tray_group_begin(void *group) {
+    if (!group) return;
+    static_cast<TrayGroup *>(group)->begin();
+}
+
+void tray_group_commit(void *group) {
+    if (!group) return;
+
+    TrayGroup *g = static_cast<TrayGroup *>(group);
+    const QList<TrayGroup::Change> changes = g->takePending();
+    run_group_changes(g, changes);
+
+    sni_log("Committed tray group: %d changes", changes.size());
+}
+
+void tray_group_set_status(void *group, const char *status) {
+    if (!group || !status) return;
+
+    QString qstatus = QString::fromUtf8(status);
+    group_change(static_cast<TrayGroup *>(group), [qstatus](StatusNotifierItem *sni) {
+        sni->setStatus(qstatus);
+    });
+
+    sni_log("Set group status: %s", status);
+}
+
+void tray_group_set_title(void *group, const char *title) {
+    if (!group || !title) return;
+
+    QString qtitle = QString::fromUtf8(title);
+    group_change(static_cast<TrayGroup *>(group), [qtitle](StatusNotifierItem *sni) {
+        sni->setTitle(qtitle);
+    });
+
+    sni_log("Set group title: %s", title);
+}
+
+void tray_group_set_tooltip_title(void *group, const char *title) {
+    if (!group || !title) return;
+
+    QString qtitle = QString::fromUtf8(title);
+    group_change(static_cast<TrayGroup *>(group), [qtitle](StatusNotifierItem *sni) {
+        sni->setToolTipTitle(qtitle);
+    });
+
+    sni_log("Set group tooltip title: %s", title);
+}
+
+void tray_group_set_icon_by_name(void *group, const char *name) {
+    if (!group || !name) return;
+
+    QString qname = QString::fromUtf8(name);
+    group_change(static_cast<TrayGroup *>(group), [qname](StatusNotifierItem *sni) {
+        detach_icon_sources(sni);
+        sni->setIconByName(qname);
+    });
+
+    sni_log("Set group icon by name: %s", name);
+}
+
+void tray_group_set_icon_handle(void *group, void *icon) {
+    if (!group || !icon) return;
+
+    // La modification en attente garde l'icône en vie jusqu'au commit
+    SharedIcon *shared = static_cast<SharedIcon *>(icon);
+    shared->ref();
+    std::shared_ptr<SharedIcon> keep(shared, [](SharedIcon *i) { i->deref(); });
+
+    group_change(static_cast<TrayGroup *>(group), [keep](StatusNotifierItem *sni) {
+        detach_icon_sources(sni);
+        if (!keep->themeName().isEmpty())
+            sni->setIconByName(keep->themeName());
+        else
+            sni->setIconByPixmaps(keep->pixmaps().pixmaps, keep->pixmaps().key);
+    });
+
+    sni_log("Set group icon handle");
+}
+
+// ------------------- Light/dark icon variants -------------------
+
+void set_icon_themed(void *handle, void *light_icon, void *dark_icon) {
+    if (!handle || !light_icon || !dark_icon) return;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+    SharedIcon *light = static_cast<SharedIcon *>(light_icon);
+    SharedIcon *dark = static_cast<SharedIcon *>(dark_icon);
+
+    QMetaObject::invokeMethod(sni, [sni, light, dark]() {
+        detach_icon_sources(sni, IconSourceThemed);
+        ColorSchemeWatcher::instance()->setThemedIcon(sni, light, dark);
+    }, safeConn(sni));
+
+    sni_log("Set themed icon");
+}
+
+void set_menu_item_icon_themed(void *menu_item_handle, void *light_icon, void *dark_icon) {
+    if (!menu_item_handle || !light_icon || !dark_icon) return;
+
+    QAction *action = static_cast<QAction *>(menu_item_handle);
+    SharedIcon *light = static_cast<SharedIcon *>(light_icon);
+    SharedIcon *dark = static_cast<SharedIcon *>(dark_icon);
+    auto mgr = SNIWrapperManager::instance();
+
+    QMetaObject::invokeMethod(mgr, [action, light, dark]() {
+        ColorSchemeWatcher::instance()->setThemedIcon(action, light, dark);
+    }, safeConn(mgr));
+
+    sni_log("Set themed menu item icon");
+}
+
+void sni_set_color_scheme(int scheme) {
+    auto mgr = SNIWrapperManager::instance();
+
+    QMetaObject::invokeMethod(mgr, [scheme]() {
+        ColorSchemeWatcher::instance()->setForced(scheme);
+    }, safeConn(mgr));
+
+    sni_log("Set color scheme: %d", scheme);
+}
+
+int sni_get_color_scheme(void) {
+    int dark = 0;
+    auto mgr = SNIWrapperManager::instance();
+
+    QMetaObject::invokeMethod(mgr, [&dark]() {
+        dark = ColorSchemeWatcher::instance()->isDark() ? 1 : 0;
+    }, safeConn(mgr));
+
+    return dark;
+}
+
+// ------------------- Attention animation -------------------
+
+static void set_attention_movie_impl(StatusNotifierItem *sni, const QString &name,
+                                     const QList<QIcon> &frames, int intervalMs, bool installed) {
+    if (installed)
+        sni->setIconThemePath(PrivateIconTheme::instance().path());
+    sni->setAttentionMovie(installed ? name : QString(), frames, intervalMs);
+}
+
+int set_attention_movie_by_path(void *handle, const char *movie_path, int native_fallback) {
+    if (!handle || !movie_path) return -1;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+    QString qpath = QString::fromUtf8(movie_path);
+    bool ok = false;
+
+    QMetaObject::invokeMethod(sni, [sni, qpath, native_fallback, &ok]() {
+        const QString name = sni->id() + QLatin1Char('-') + QFileInfo(qpath).completeBaseName();
+        if (!PrivateIconTheme::isValidName(name))
+            sni_log("Attention movie name rejected: %s", qPrintable(name));
+        ok = PrivateIconTheme::instance().installMovie(name, qpath);
+
+        // Images du film pour le repli (première image au minimum)
+        QList<QIcon> frames;
+        int interval = 0;
+        QImageReader reader(qpath);
+        for (QImage img = reader.read(); !img.isNull(); img = reader.read()) {
+            if (interval <= 0)
+                interval = reader.nextImageDelay();
+            frames.append(QIcon(QPixmap::fromImage(img)));
+            if (!native_fallback || !reader.supportsAnimation())
+                break;
+        }
+        if (interval <= 0)
+            interval = 100;
+
+        set_attention_movie_impl(sni, name, frames, native_fallback ? interval : 0, ok);
+    }, safeConn(sni));
+
+    sni_log("Set attention movie: %s (%s)", movie_path, ok ? "installed" : "failed");
+    return ok ? 0 : -1;
+}
+
+int set_attention_movie_frames(void *handle, const char *name, const char *const *frame_paths,
+                               int count, int frame_interval_ms, int native_fallback) {
+    if (!handle || !name || !frame_paths || count <= 0) return -1;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+    QString qname = QString::fromUtf8(name);
+    QStringList paths;
+    for (int i = 0; i < count; ++i) {
+        if (!frame_paths[i]) return -1;     // tout ou rien
+        paths.append(QString::fromUtf8(frame_paths[i]));
+    }
+    bool ok = false;
+
+    QMetaObject::invokeMethod(sni, [sni, qname, paths, frame_interval_ms, native_fallback, &ok]() {
+        const QString movieName = sni->id() + QLatin1Char('-') + qname;
+        if (!PrivateIconTheme::isValidName(movieName))
+            sni_log("Attention movie name rejected: %s", qPrintable(movieName));
+        ok = PrivateIconTheme::instance().installFrames(movieName, paths);
+
+        QList<QIcon> frames;
+        for (const QString &path : paths) {
+            frames.append(QIcon(path));
+            if (!native_fallback)
+                break;
+        }
+
+        set_attention_movie_impl(sni, movieName, frames, native_fallback ? frame_interval_ms : 0, ok);
+    }, safeConn(sni));
+
+    sni_log("Set attention movie frames: %s (%d frames)", name, count);
+    return ok ? 0 : -1;
+}
+
+// ------------------- Pull-model property providers -------------------
+
+void set_property_provider(void *handle, int property, PropertyProviderCallback cb, void *data, int ttl_ms) {
+    if (!handle) return;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+    const int ttl = ttl_ms > 0 ? ttl_ms : 0;
+
+    QMetaObject::invokeMethod(sni, [sni, property, cb, data, ttl]() {
+        std::function<QString()> text;
+        if (cb) {
+            text = [cb, data]() {
+                const char *value = cb(data);
+                return value ? QString::fromUtf8(value) : QString();
+            };
+        }
+
+        switch (property) {
+        case SNI_PROPERTY_TOOLTIP_TITLE:
+            sni->setToolTipTitleProvider(text, ttl);
+            break;
+        case SNI_PROPERTY_TOOLTIP_SUBTITLE:
+            sni->setToolTipSubTitleProvider(text, ttl);
+            break;
+        case SNI_PROPERTY_ICON_PATH:
+            if (text)
+                sni->setIconProvider([text]() { return QIcon(text()); }, ttl);
+            else
+                sni->setIconProvider(nullptr, ttl);
+            break;
+        default:
+            break;
+        }
+    }, safeConn(sni));
+
+    sni_log("Set property provider: %d (ttl %d ms)", property, ttl);
+}
+
+void invalidate_property(void *handle, int property) {
+    if (!handle) return;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+
+    switch (property) {
+    case SNI_PROPERTY_TOOLTIP_TITLE:
+    case SNI_PROPERTY_TOOLTIP_SUBTITLE:
+        QMetaObject::invokeMethod(sni, [sni]() { sni->invalidateToolTip(); }, safeConn(sni));
+        break;
+    case SNI_PROPERTY_ICON_PATH:
+        QMetaObject::invokeMethod(sni, [sni]() { sni->invalidateIcon(); }, safeConn(sni));
+        break;
+    default:
+        sni_log("Ignored invalidation of unknown property: %d", property);
+        return;
+    }
+
+    sni_log("Invalidated property: %d", property);
+}
+
 // ------------------- Menu creation & management -------------------
 
 void *create_menu(void) {
@@ -351,6 +1125,8 @@ void destroy_menu(void *menu_handle) {
 
     QMetaObject::invokeMethod(mgr, [menu]() {
         menu->disconnect();
+        for (QAction *action : menu->actions())
+            purge_action_callbacks(action);
         menu->clear();
         menu->deleteLater();
         qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
@@ -382,6 +1158,18 @@ void set_context_menu(void *handle, void *menu_handle) {
     sni_log("Set context menu");
 }
 
+void tray_set_item_is_menu(void *handle, int item_is_menu) {
+    if (!handle) return;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+
+    QMetaObject::invokeMethod(sni, [sni, item_is_menu]() {
+        sni->setItemIsMenu(item_is_menu != 0);
+    }, safeConn(sni));
+
+    sni_log("Set item is menu: %d", item_is_menu);
+}
+
 void *add_menu_action(void *menu_handle, const char *text, ActionCallback cb, void *data) {
     if (!menu_handle || !text) return nullptr;
 
@@ -393,8 +1181,9 @@ void *add_menu_action(void *menu_handle, const char *text, ActionCallback cb, vo
     QMetaObject::invokeMethod(mgr, [&]() {
         QAction *action = menu->addAction(qtext);
         if (cb) {
-            QObject::connect(action, &QAction::triggered, [cb, data]() {
-                if (cb) cb(data);
+            QObject::connect(action, &QAction::triggered, action, [cb, data, action]() {
+                // File interactive : passe devant animations et rechargements
+                post_callback(action, 0, [cb, data]() { cb(data); });
             });
         }
         result = action;
@@ -416,8 +1205,8 @@ void *add_disabled_menu_action(void *menu_handle, const char *text, ActionCallba
         QAction *action = menu->addAction(qtext);
         action->setEnabled(false);
         if (cb) {
-            QObject::connect(action, &QAction::triggered, [cb, data]() {
-                if (cb) cb(data);
+            QObject::connect(action, &QAction::triggered, action, [cb, data, action]() {
+                post_callback(action, 0, [cb, data]() { cb(data); });
             });
         }
         result = action;
@@ -440,8 +1229,8 @@ void* add_checkable_menu_action(void *menu_handle, const char *text, int checked
         action->setCheckable(true);
         action->setChecked(checked != 0);
         if (cb) {
-            QObject::connect(action, &QAction::triggered, [cb, data]() {
-                if (cb) cb(data);
+            QObject::connect(action, &QAction::triggered, action, [cb, data, action]() {
+                post_callback(action, 0, [cb, data]() { cb(data); });
             });
         }
         result = action;
@@ -511,6 +1300,22 @@ void set_submenu_icon(void* submenu_handle, const char* icon_path_or_name) {
     sni_log("Set submenu icon: %s", icon_path_or_name);
 }
 
+void set_submenu_icon_handle(void *submenu_handle, void *icon) {
+    if (!submenu_handle || !icon) return;
+
+    QMenu *submenu = static_cast<QMenu *>(submenu_handle);
+    SharedIcon *shared = static_cast<SharedIcon *>(icon);
+    auto mgr = SNIWrapperManager::instance();
+
+    QMetaObject::invokeMethod(mgr, [submenu, shared]() {
+        QAction* action = submenuToAction.value(submenu, nullptr);
+        if (action)
+            action->setIcon(shared->icon());
+    }, safeConn(mgr));
+
+    sni_log("Set submenu icon handle");
+}
+
 void set_menu_item_text(void *menu_item_handle, const char *text) {
     if (!menu_item_handle || !text) return;
 
@@ -537,6 +1342,8 @@ void set_menu_item_icon(void *menu_item_handle,
 
     QMetaObject::invokeMethod(mgr, [action, qstr]()
     {
+        ColorSchemeWatcher::forget(action);
+
         /* 1) Essaye d’abord le thème d’icônes */
         QIcon ico = QIcon::fromTheme(qstr);
 
@@ -551,6 +1358,42 @@ void set_menu_item_icon(void *menu_item_handle,
 }
 
 
+void set_menu_item_icon_handle(void *menu_item_handle, void *icon) {
+    if (!menu_item_handle || !icon) return;
+
+    QAction *action = static_cast<QAction *>(menu_item_handle);
+    SharedIcon *shared = static_cast<SharedIcon *>(icon);
+    auto mgr = SNIWrapperManager::instance();
+
+    QMetaObject::invokeMethod(mgr, [action, shared]() {
+        ColorSchemeWatcher::forget(action);
+        action->setIcon(shared->icon());
+    }, safeConn(mgr));
+
+    sni_log("Set menu item icon handle");
+}
+
+void set_menu_item_icon_encoded(void *menu_item_handle, const void *data, size_t len,
+                                const char *format_hint) {
+    if (!menu_item_handle || !data || len == 0 || !encoded_length_ok(len)) return;
+
+    QAction *action = static_cast<QAction *>(menu_item_handle);
+    QByteArray bytes = QByteArray::fromRawData(static_cast<const char *>(data), int(len));
+    QByteArray format = format_hint ? QByteArray(format_hint) : QByteArray();
+    auto mgr = SNIWrapperManager::instance();
+
+    QMetaObject::invokeMethod(mgr, [action, &bytes, &format]() {
+        ColorSchemeWatcher::forget(action);
+        SharedIcon *icon = IconCache::instance().fromEncoded(bytes, format);
+        if (!icon)
+            return;
+        action->setIcon(icon->icon());
+        icon->deref();
+    }, safeConn(mgr));
+
+    sni_log("Set menu item encoded icon: %zu bytes", len);
+}
+
 void set_menu_item_enabled(void *menu_item_handle, int enabled) {
     if (!menu_item_handle) return;
 
@@ -589,6 +1432,8 @@ void remove_menu_item(void *menu_handle, void *menu_item_handle) {
 
     QMetaObject::invokeMethod(mgr, [menu, action]() {
         menu->removeAction(action);
+        action->disconnect();
+        purge_action_callbacks(action);
         action->deleteLater();
     }, safeConn(mgr));
 
@@ -637,14 +1482,16 @@ void set_activate_callback(void *handle, ActivateCallback cb, void *data) {
     StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
 
     QMetaObject::invokeMethod(sni, [sni, cb, data]() {
-        QObject::disconnect(sni, &StatusNotifierItem::activateRequested, nullptr, nullptr);
+        drop_callback(sni, CallbackActivate);
 
         if (cb) {
-            QObject::connect(sni, &StatusNotifierItem::activateRequested, sni,
-                             [cb, data](const QPoint &pos) {
-                                 if (cb) cb(pos.x(), pos.y(), data);
-                             },
-                             Qt::DirectConnection);
+            callback_connection(sni, CallbackActivate) =
+                QObject::connect(sni, &StatusNotifierItem::activateRequested, sni,
+                                 [sni, cb, data](const QPoint &pos) {
+                                     post_callback(sni, CallbackActivate,
+                                                   [cb, data, pos]() { cb(pos.x(), pos.y(), data); });
+                                 },
+                                 Qt::DirectConnection);
         }
     }, safeConn(sni));
 
@@ -657,14 +1504,16 @@ void set_secondary_activate_callback(void *handle, SecondaryActivateCallback cb,
     StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
 
     QMetaObject::invokeMethod(sni, [sni, cb, data]() {
-        QObject::disconnect(sni, &StatusNotifierItem::secondaryActivateRequested, nullptr, nullptr);
+        drop_callback(sni, CallbackSecondaryActivate);
 
         if (cb) {
-            QObject::connect(sni, &StatusNotifierItem::secondaryActivateRequested, sni,
-                             [cb, data](const QPoint &pos) {
-                                 if (cb) cb(pos.x(), pos.y(), data);
-                             },
-                             Qt::DirectConnection);
+            callback_connection(sni, CallbackSecondaryActivate) =
+                QObject::connect(sni, &StatusNotifierItem::secondaryActivateRequested, sni,
+                                 [sni, cb, data](const QPoint &pos) {
+                                     post_callback(sni, CallbackSecondaryActivate,
+                                                   [cb, data, pos]() { cb(pos.x(), pos.y(), data); });
+                                 },
+                                 Qt::DirectConnection);
         }
     }, safeConn(sni));
 
@@ -677,20 +1526,67 @@ void set_scroll_callback(void *handle, ScrollCallback cb, void *data) {
     StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
 
     QMetaObject::invokeMethod(sni, [sni, cb, data]() {
-        QObject::disconnect(sni, &StatusNotifierItem::scrollRequested, nullptr, nullptr);
+        drop_callback(sni, CallbackScroll);
 
         if (cb) {
-            QObject::connect(sni, &StatusNotifierItem::scrollRequested, sni,
-                             [cb, data](int delta, Qt::Orientation orientation) {
-                                 if (cb) cb(delta, orientation == Qt::Horizontal ? 1 : 0, data);
-                             },
-                             Qt::DirectConnection);
+            callback_connection(sni, CallbackScroll) =
+                QObject::connect(sni, &StatusNotifierItem::scrollRequested, sni,
+                                 [sni, cb, data](int delta, Qt::Orientation orientation) {
+                                     const int orient = orientation == Qt::Horizontal ? 1 : 0;
+                                     post_callback(sni, CallbackScroll,
+                                                   [cb, data, delta, orient]() { cb(delta, orient, data); });
+                                 },
+                                 Qt::DirectConnection);
         }
     }, safeConn(sni));
 
     sni_log("Set scroll callback");
 }
 
+void set_scroll_coalescing(void *handle, int window_ms, int notch) {
+    if (!handle) return;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+
+    QMetaObject::invokeMethod(sni, [sni, window_ms, notch]() {
+        sni->setScrollCoalescing(window_ms, notch);
+    }, safeConn(sni));
+
+    sni_log("Set scroll coalescing: %d ms, notch %d", window_ms, notch);
+}
+
+void set_click_gesture_callback(void *handle, ClickGestureCallback cb, void *data,
+                                int multi_click_ms, int max_clicks) {
+    if (!handle) return;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+
+    QMetaObject::invokeMethod(sni, [sni, cb, data, multi_click_ms, max_clicks]() {
+        drop_callback(sni, CallbackClickGesture);
+        TrayCallbacks &state = g_trayCallbacks[sni];
+        state.gestureCallback = cb != nullptr;
+        if (cb) {
+            state.multiClickMs = multi_click_ms;
+            state.maxClicks = max_clicks;
+        }
+        update_click_gestures(sni);
+
+        if (cb) {
+            callback_connection(sni, CallbackClickGesture) =
+                QObject::connect(sni, &StatusNotifierItem::clickGestureRecognized, sni,
+                                 [sni, cb, data](int gesture, int clicks, const QPoint &pos) {
+                                     post_callback(sni, CallbackClickGesture,
+                                                   [cb, data, gesture, clicks, pos]() {
+                                                       cb(gesture, clicks, pos.x(), pos.y(), data);
+                                                   });
+                                 },
+                                 Qt::DirectConnection);
+        }
+    }, safeConn(sni));
+
+    sni_log("Set click gesture callback: %d ms, max %d clicks", multi_click_ms, max_clicks);
+}
+
 // ------------------- Notifications -------------------
 
 void show_notification(void *handle, const char *title, const char *msg, const char *iconName, int secs) {
@@ -708,6 +1604,91 @@ void show_notification(void *handle, const char *title, const char *msg, const c
     sni_log("Showed notification: %s", title ? title : "");
 }
 
+int show_notification_async(void *handle, const char *title, const char *msg, const char *iconName,
+                            int secs, AsyncReplyCallback cb, void *data) {
+    if (!handle) return 0;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+    QString qtitle = title ? QString::fromUtf8(title) : QString();
+    QString qmsg = msg ? QString::fromUtf8(msg) : QString();
+    QString qiconName = iconName ? QString::fromUtf8(iconName) : QString();
+    const quint64 serial = cb ? TrayReplies::begin(sni, cb, data) : 0;
+
+    QMetaObject::invokeMethod(sni, [sni, qtitle, qmsg, qiconName, secs, cb, data, serial]() {
+        std::function<void(quint32)> onReply;
+        if (cb)
+            onReply = [data, serial](quint32 id) { TrayReplies::finish(data, serial, id); };
+        sni->showMessage(qtitle, qmsg, qiconName, secs * 1000, std::move(onReply));
+    }, Qt::QueuedConnection);
+
+    sni_log("Sent async notification: %s", title ? title : "");
+    return 1;
+}
+
+int tray_publish_async(void *handle, AsyncReplyCallback cb, void *data) {
+    if (!handle) return 0;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+    const quint64 serial = cb ? TrayReplies::begin(sni, cb, data) : 0;
+
+    QMetaObject::invokeMethod(sni, [sni, cb, data, serial]() {
+        if (cb) {
+            // Already answered: report the known outcome instead of waiting
+            if (sni->isPublished() && sni->registration() != StatusNotifierItem::RegistrationPending) {
+                TrayReplies::finish(data, serial, sni->registration() == StatusNotifierItem::Registered);
+                return;
+            }
+            // One-shot: the context object goes with the first answer
+            auto *once = new QObject(sni);
+            QObject::connect(sni, &StatusNotifierItem::registrationFinished, once,
+                             [sni, once, data, serial](bool registered) {
+                                 QObject::disconnect(sni, nullptr, once, nullptr);
+                                 once->deleteLater();
+                                 TrayReplies::finish(data, serial, registered ? 1 : 0);
+                             });
+        }
+        sni->publish();
+    }, Qt::QueuedConnection);
+
+    sni_log("Publishing tray (async)");
+    return 1;
+}
+
+int sni_cancel_async(void *data) {
+    return TrayReplies::cancel(data) ? 1 : 0;
+}
+
+// ------------------- Event ring -------------------
+
+int tray_enable_events(void *handle, int capacity, unsigned int flags) {
+    if (!handle) return 0;
+
+    StatusNotifierItem *sni = static_cast<StatusNotifierItem *>(handle);
+    QMetaObject::invokeMethod(sni, [sni, capacity, flags]() {
+        TrayEventRing::install(sni, capacity);
+        g_trayCallbacks[sni].gestureEvents = capacity > 0 && (flags & SNI_EVENTS_CLICK_GESTURES);
+        update_click_gestures(sni);
+    }, safeConn(sni));
+
+    sni_log("Event ring: %d entries, flags 0x%x", capacity, flags);
+    return 1;
+}
+
+int tray_poll_event(void *handle, struct sni_event *out) {
+    if (!handle || !out) return 0;
+    return TrayEventRing::poll(static_cast<StatusNotifierItem *>(handle), out) ? 1 : 0;
+}
+
+int tray_next_event(void *handle, struct sni_event *out, EventReadyCallback cb, void *data) {
+    if (!handle || !out || !cb) return -1;
+    return TrayEventRing::next(static_cast<StatusNotifierItem *>(handle), out, cb, data);
+}
+
+int tray_cancel_event_wait(void *handle, void *data) {
+    if (!handle) return 0;
+    return TrayEventRing::cancel(static_cast<StatusNotifierItem *>(handle), data) ? 1 : 0;
+}
+
 // ------------------- Event loop management -------------------
 
 int sni_exec(void) {
@@ -730,6 +1711,74 @@ void sni_stop_exec(void) {
     sni_log("Stopped event loop");
 }
 
+void sni_set_queue_limits(int capacity, int overflow_policy) {
+    QtThreadManager::Overflow policy = QtThreadManager::Overflow::Block;
+    if (overflow_policy == SNI_OVERFLOW_DROP)
+        policy = QtThreadManager::Overflow::Drop;
+    else if (overflow_policy == SNI_OVERFLOW_REPLACE)
+        policy = QtThreadManager::Overflow::Replace;
+
+    QtThreadManager::setQueueLimits(capacity, policy);
+    sni_log("Set queue limits: capacity %d, policy %d", capacity, overflow_policy);
+}
+
+void sni_set_async_setters(int enabled) {
+    g_asyncSetters.store(enabled != 0);
+    sni_log("Async property setters: %s", enabled ? "on" : "off");
+}
+
+static_assert(SNI_THREAD_NICE == QtThreadManager::ConfigNice && SNI_THREAD_SCHED == QtThreadManager::ConfigSched
+              && SNI_THREAD_AFFINITY == QtThreadManager::ConfigAffinity && SNI_THREAD_NAME == QtThreadManager::ConfigName
+              && SNI_THREAD_STACK == QtThreadManager::ConfigStack, "thread config flags must match");
+
+int sni_set_thread_config(const struct sni_thread_config *config) {
+    if (!config) return -1;
+    if ((config->flags & SNI_THREAD_NICE) && (config->nice < -20 || config->nice > 19)) return -1;
+    if ((config->flags & SNI_THREAD_AFFINITY) && config->affinity_mask == 0) return -1;
+    if ((config->flags & SNI_THREAD_NAME) && !config->name) return -1;
+    if ((config->flags & SNI_THREAD_STACK) && config->stack_size > UINT_MAX) return -1;
+
+    QtThreadManager::ThreadConfig cfg;
+    cfg.flags = config->flags;
+    cfg.nice = config->nice;
+    cfg.schedPolicy = config->sched_policy;
+    cfg.schedPriority = config->sched_priority;
+    cfg.affinityMask = config->affinity_mask;
+    cfg.name = config->name ? QByteArray(config->name) : QByteArray();
+    cfg.stackSize = uint(config->stack_size);
+
+    const unsigned failed = QtThreadManager::setThreadConfig(cfg);
+    if (failed)
+        sni_log("Thread settings not applied: flags 0x%x", failed);
+    sni_log("Set thread config: flags 0x%x", config->flags);
+    return 0;
+}
+
+void sni_get_queue_stats(struct sni_queue_stats *out, int reset) {
+    if (!out) return;
+
+    QtThreadManager::LaneStats lanes[QtThreadManager::LaneCount];
+    QtThreadManager::laneStats(lanes, reset != 0);
+    const QtThreadManager::QueueStats queue = QtThreadManager::queueStats(reset != 0);
+
+    for (int i = 0; i < SNI_LANE_COUNT; ++i) {
+        out->lanes[i].executed = lanes[i].executed;
+        out->lanes[i].total_delay_ns = lanes[i].totalDelayNs;
+        out->lanes[i].max_delay_ns = lanes[i].maxDelayNs;
+        out->lanes[i].pending = unsigned(lanes[i].pending);
+    }
+    out->coalesced = queue.coalesced;
+    out->dropped = queue.dropped;
+    out->evicted = queue.evicted;
+    out->blocked = queue.blocked;
+    out->capacity = unsigned(queue.capacity);
+
+    const QtThreadManager::ThreadUsage usage = QtThreadManager::threadUsage();
+    out->thread_cpu_ns = usage.cpuNs;
+    out->thread_voluntary_switches = usage.voluntarySwitches;
+    out->thread_involuntary_switches = usage.involuntarySwitches;
+}
+
 void sni_process_events(void) {
     QtThreadManager::instance()->runBlocking([] {
         auto mgr = SNIWrapperManager::instance();
@@ -748,6 +1797,7 @@ void clear_menu(void *menu_handle) {
     QMetaObject::invokeMethod(mgr, [menu]() {
         for (QAction *action: menu->actions()) {
             action->disconnect();
+            purge_action_callbacks(action);
         }
         menu->clear();
         qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
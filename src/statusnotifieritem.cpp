@@ -27,12 +27,18 @@
 
 #include "statusnotifieritem.h"
 #include "statusnotifieritemadaptor.h"
+#include "icontint.h"
+#include "qtthreadmanager.h"
 
 #include <QCoreApplication>
+#include <QGuiApplication>
+#include <QStyleHints>
 #include <QDBusConnection>
 #include <QDBusInterface>
 #include <QDBusMessage>
 #include <QDBusObjectPath>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
 #include <QDBusServiceWatcher>
 #include <QtEndian>
 #include <QMenu>
@@ -42,6 +48,8 @@
 #include <QSysInfo>
 #include <QSize>
 #include <QPoint>
+#include <QTimer>
+#include <QPointer>
 #include <QVariantMap>
 #include <QList>
 #include <utility>
@@ -50,25 +58,33 @@
 int StatusNotifierItem::mServiceCounter = 0;
 
 // ------------------------------------------------------------------
-// Utilitaire : chemin DBus à utiliser quand il n'y a PAS de menu.
-// - KDE/Plasma : "/NO_DBUSMENU"
-// - GNOME/Autres : "/"
-// Détection simple via variables d'environnement.
+// Détection simple de l'hôte via variables d'environnement.
 // ------------------------------------------------------------------
-static inline QString noMenuPathForEnvironment()
+static inline bool isKdeSession()
 {
     const QString xdg  = qEnvironmentVariable("XDG_CURRENT_DESKTOP").toLower();
     const QString sess = qEnvironmentVariable("DESKTOP_SESSION").toLower();
     const bool kdeFull = qEnvironmentVariableIsSet("KDE_FULL_SESSION");
 
-    if (xdg.contains("kde") || xdg.contains("plasma") ||
-        sess.contains("kde") || sess.contains("plasma") || kdeFull) {
-        return QLatin1String("/NO_DBUSMENU");
-    }
-    return QLatin1String("/");
+    return xdg.contains("kde") || xdg.contains("plasma") ||
+           sess.contains("kde") || sess.contains("plasma") || kdeFull;
+}
+
+// Chemin DBus à utiliser quand il n'y a PAS de menu.
+// - KDE/Plasma : "/NO_DBUSMENU"
+// - GNOME/Autres : "/"
+static inline QString noMenuPathForEnvironment()
+{
+    return isKdeSession() ? QLatin1String("/NO_DBUSMENU") : QLatin1String("/");
+}
+
+// Plasma joue AttentionMovieName ; les autres hôtes l'ignorent
+static inline bool hostPlaysAttentionMovie()
+{
+    return isKdeSession();
 }
 
-StatusNotifierItem::StatusNotifierItem(QString id, QObject *parent)
+StatusNotifierItem::StatusNotifierItem(QString id, QObject *parent, bool deferRegistration)
     : QObject(parent),
       mAdaptor(new StatusNotifierItemAdaptor(this)),
       mService(QString::fromLatin1("org.freedesktop.StatusNotifierItem-%1-%2")
@@ -78,10 +94,33 @@ StatusNotifierItem::StatusNotifierItem(QString id, QObject *parent)
       mTitle(QLatin1String("Test")),
       mStatus(QLatin1String("Active")),
       mCategory(QLatin1String("ApplicationStatus")),
+      mIconCacheKey(0),
+      mOverlayIconCacheKey(0),
+      mAttentionIconCacheKey(0),
+      mIconSourceKey(0),
+      mIconTint(0),
+      mIconIsFrame(false),
+      mAttentionFrameIndex(0),
+      mAttentionTimer(nullptr),
+      mTooltipIconCacheKey(0),
       mMenu(nullptr),
       mMenuPath(QLatin1String("/")),              // valeur initiale ; corrigée juste après
+      mItemIsMenu(false),
       mMenuExporter(nullptr),
-      mSessionBus(QDBusConnection::connectToBus(QDBusConnection::SessionBus, mService))
+      mSessionBus(QDBusConnection::connectToBus(QDBusConnection::SessionBus, mService)),
+      mScrollWindowMs(0),
+      mScrollNotch(0),
+      mScrollAccum{0, 0},
+      mScrollCarry{0, 0},
+      mScrollTimer(nullptr),
+      mClickGestures(false),
+      mMaxClicks(3),
+      mClickCount(0),
+      mClickTimer(nullptr),
+      mPublished(false),
+      mRegistration(RegistrationPending),
+      mUpdateDepth(0),
+      mPendingSignals(0)
 {
     // Enregistrer nos types D-Bus (une seule fois)
     static bool s_registered = false;
@@ -92,12 +131,23 @@ StatusNotifierItem::StatusNotifierItem(QString id, QObject *parent)
         s_registered = true;
     }
 
-    // Publier l’objet
-    mSessionBus.registerObject(QLatin1String("/StatusNotifierItem"), this);
-
     // Chemin « pas de menu » adapté à l’environnement courant
     setMenuPath(noMenuPathForEnvironment());
 
+    if (!deferRegistration)
+        publish();
+}
+
+void StatusNotifierItem::publish()
+{
+    if (mPublished)
+        return;
+    mPublished = true;
+
+    // Publier l’objet avec son état courant : le premier GetAll de l’hôte
+    // voit directement les valeurs finales.
+    mSessionBus.registerObject(QLatin1String("/StatusNotifierItem"), this);
+
     registerToHost();
 
     // Re-registration si le watcher/host change de propriétaire
@@ -120,7 +170,18 @@ void StatusNotifierItem::registerToHost()
                              QLatin1String("/StatusNotifierWatcher"),
                              QLatin1String("org.kde.StatusNotifierWatcher"),
                              mSessionBus);
-    interface.asyncCall(QLatin1String("RegisterStatusNotifierItem"), mSessionBus.baseService());
+    QDBusPendingCall call = interface.asyncCall(QLatin1String("RegisterStatusNotifierItem"),
+                                                mSessionBus.baseService());
+
+    mRegistration = RegistrationPending;
+    auto *watcher = new QDBusPendingCallWatcher(call, this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this,
+            [this](QDBusPendingCallWatcher *call) {
+                call->deleteLater();
+                const bool ok = !call->isError();
+                mRegistration = ok ? Registered : RegistrationFailed;
+                Q_EMIT registrationFinished(ok);
+            });
 }
 
 void StatusNotifierItem::onServiceOwnerChanged(const QString& service,
@@ -154,7 +215,7 @@ void StatusNotifierItem::setTitle(const QString &title)
     if (mTitle == title)
         return;
     mTitle = title;
-    Q_EMIT mAdaptor->NewTitle();
+    emitChanged(TitleChanged);
 }
 
 void StatusNotifierItem::setStatus(const QString &status)
@@ -162,7 +223,8 @@ void StatusNotifierItem::setStatus(const QString &status)
     if (mStatus == status)
         return;
     mStatus = status;
-    Q_EMIT mAdaptor->NewStatus(mStatus);
+    updateAttentionAnimation();
+    emitChanged(StatusChanged);
 }
 
 void StatusNotifierItem::setCategory(const QString &category)
@@ -182,6 +244,61 @@ void StatusNotifierItem::setMenuPath(const QString& path)
     mMenuPath.setPath(path);
 
     // Informer l’hôte que la propriété « Menu » a changé
+    notifyPropertyChanged(QLatin1String("Menu"), QVariant::fromValue(menu()));
+}
+
+void StatusNotifierItem::setItemIsMenu(bool itemIsMenu)
+{
+    if (mItemIsMenu == itemIsMenu)
+        return;
+
+    mItemIsMenu = itemIsMenu;
+    notifyPropertyChanged(QLatin1String("ItemIsMenu"), mItemIsMenu);
+}
+
+/* Propriétés sans signal New* dans la spécification : PropertiesChanged */
+void StatusNotifierItem::beginUpdate()
+{
+    ++mUpdateDepth;
+}
+
+void StatusNotifierItem::endUpdate()
+{
+    if (mUpdateDepth == 0 || --mUpdateDepth > 0)
+        return;
+
+    // Un seul signal par type, dans l'état final
+    const int pending = mPendingSignals;
+    mPendingSignals = 0;
+    for (int bit = TitleChanged; bit <= StatusChanged; bit <<= 1) {
+        if (pending & bit)
+            emitChanged(ChangedSignal(bit));
+    }
+}
+
+void StatusNotifierItem::emitChanged(ChangedSignal signal)
+{
+    if (mUpdateDepth > 0) {
+        mPendingSignals |= signal;
+        return;
+    }
+
+    switch (signal) {
+    case TitleChanged:         Q_EMIT mAdaptor->NewTitle(); break;
+    case IconChanged:          Q_EMIT mAdaptor->NewIcon(); break;
+    case AttentionIconChanged: Q_EMIT mAdaptor->NewAttentionIcon(); break;
+    case OverlayIconChanged:   Q_EMIT mAdaptor->NewOverlayIcon(); break;
+    case ToolTipChanged:       Q_EMIT mAdaptor->NewToolTip(); break;
+    case StatusChanged:        Q_EMIT mAdaptor->NewStatus(mStatus); break;
+    }
+}
+
+void StatusNotifierItem::notifyPropertyChanged(const QString &name, const QVariant &value)
+{
+    // Pas encore publié : l’hôte lira la valeur lors de son premier GetAll
+    if (!mPublished)
+        return;
+
     QDBusMessage msg = QDBusMessage::createSignal(
         QLatin1String("/StatusNotifierItem"),
         QLatin1String("org.freedesktop.DBus.Properties"),
@@ -190,12 +307,21 @@ void StatusNotifierItem::setMenuPath(const QString& path)
     msg << QLatin1String("org.kde.StatusNotifierItem");
 
     QVariantMap changed;
-    changed.insert(QLatin1String("Menu"), QVariant::fromValue(menu()));
+    changed.insert(name, value);
     msg << changed << QStringList{}; // pas de propriétés invalidées
 
     mSessionBus.send(msg);
 }
 
+void StatusNotifierItem::setIconThemePath(const QString &path)
+{
+    if (mIconThemePath == path)
+        return;
+
+    mIconThemePath = path;
+    notifyPropertyChanged(QLatin1String("IconThemePath"), mIconThemePath);
+}
+
 /* ---------------------- Icônes ---------------------- */
 
 void StatusNotifierItem::setIconByName(const QString &name)
@@ -206,18 +332,78 @@ void StatusNotifierItem::setIconByName(const QString &name)
     mIconName = name;
     mIcon.clear();
     mIconCacheKey = 0;
-    Q_EMIT mAdaptor->NewIcon();
+    mIconSource.clear();
+    mIconSourceKey = 0;
+    mIconIsFrame = false;
+    emitChanged(IconChanged);
 }
 
 void StatusNotifierItem::setIconByPixmap(const QIcon &icon)
 {
-    if (mIconCacheKey == icon.cacheKey())
+    if (mIconName.isEmpty() && mIconSourceKey == icon.cacheKey())
         return;
 
-    mIconCacheKey = icon.cacheKey();
-    mIcon = iconToPixmapList(icon);
+    setIconByPixmaps(iconToPixmapList(icon), icon.cacheKey());
+}
+
+void StatusNotifierItem::setIconByPixmaps(const IconPixmapList &pixmaps, qint64 key)
+{
+    if (mIconName.isEmpty() && mIconSourceKey == key)
+        return;
+
+    mIconSourceKey = key;
+    mIconSource = pixmaps;
+    mIconIsFrame = false;
+    mIconName.clear();
+    applyIconTint();
+    emitChanged(IconChanged);
+}
+
+void StatusNotifierItem::setIconFrame(const IconPixmapList &pixmaps, qint64 key)
+{
+    mIconSourceKey = key;
+    mIconSource = pixmaps;
+    mIconIsFrame = true;
     mIconName.clear();
-    Q_EMIT mAdaptor->NewIcon();
+    applyIconTint();
+    emitChanged(IconChanged);
+}
+
+void StatusNotifierItem::setIconTint(quint32 argb)
+{
+    if (mIconTint == argb)
+        return;
+
+    mIconTint = argb;
+    if (mIconSource.isEmpty())
+        return;
+
+    applyIconTint();
+    emitChanged(IconChanged);
+}
+
+void StatusNotifierItem::applyIconTint()
+{
+    if (mIconTint == 0 || mIconSource.isEmpty()) {
+        mIcon = mIconSource;
+        mIconCacheKey = mIconSourceKey;
+        return;
+    }
+
+    // Image d'une icône vivante : jamais revue, inutile de la garder en cache
+    if (mIconIsFrame) {
+        mIcon = IconTint::recolour(mIconSource, mIconTint);
+        mIconCacheKey = mIconSourceKey;
+        return;
+    }
+
+    // Recoloration mise en cache par (clé source, couleur)
+    CachedIcon source;
+    source.key = mIconSourceKey;
+    source.pixmaps = mIconSource;
+    const CachedIcon tinted = IconTint::instance().apply(source, mIconTint);
+    mIcon = tinted.pixmaps;
+    mIconCacheKey = tinted.key;
 }
 
 void StatusNotifierItem::setOverlayIconByName(const QString &name)
@@ -228,7 +414,7 @@ void StatusNotifierItem::setOverlayIconByName(const QString &name)
     mOverlayIconName = name;
     mOverlayIcon.clear();
     mOverlayIconCacheKey = 0;
-    Q_EMIT mAdaptor->NewOverlayIcon();
+    emitChanged(OverlayIconChanged);
 }
 
 void StatusNotifierItem::setOverlayIconByPixmap(const QIcon &icon)
@@ -239,7 +425,18 @@ void StatusNotifierItem::setOverlayIconByPixmap(const QIcon &icon)
     mOverlayIconCacheKey = icon.cacheKey();
     mOverlayIcon = iconToPixmapList(icon);
     mOverlayIconName.clear();
-    Q_EMIT mAdaptor->NewOverlayIcon();
+    emitChanged(OverlayIconChanged);
+}
+
+void StatusNotifierItem::setOverlayIconByPixmaps(const IconPixmapList &pixmaps, qint64 key)
+{
+    if (mOverlayIconName.isEmpty() && mOverlayIconCacheKey == key)
+        return;
+
+    mOverlayIconCacheKey = key;
+    mOverlayIcon = pixmaps;
+    mOverlayIconName.clear();
+    emitChanged(OverlayIconChanged);
 }
 
 void StatusNotifierItem::setAttentionIconByName(const QString &name)
@@ -250,7 +447,7 @@ void StatusNotifierItem::setAttentionIconByName(const QString &name)
     mAttentionIconName = name;
     mAttentionIcon.clear();
     mAttentionIconCacheKey = 0;
-    Q_EMIT mAdaptor->NewAttentionIcon();
+    emitChanged(AttentionIconChanged);
 }
 
 void StatusNotifierItem::setAttentionIconByPixmap(const QIcon &icon)
@@ -261,7 +458,84 @@ void StatusNotifierItem::setAttentionIconByPixmap(const QIcon &icon)
     mAttentionIconCacheKey = icon.cacheKey();
     mAttentionIcon = iconToPixmapList(icon);
     mAttentionIconName.clear();
-    Q_EMIT mAdaptor->NewAttentionIcon();
+    emitChanged(AttentionIconChanged);
+}
+
+void StatusNotifierItem::setAttentionIconByPixmaps(const IconPixmapList &pixmaps, qint64 key)
+{
+    if (mAttentionIconName.isEmpty() && mAttentionIconCacheKey == key)
+        return;
+
+    mAttentionIconCacheKey = key;
+    mAttentionIcon = pixmaps;
+    mAttentionIconName.clear();
+    emitChanged(AttentionIconChanged);
+}
+
+/* ---------------------- Animation d’attention ---------------------- */
+
+void StatusNotifierItem::setAttentionMovie(const QString &name, const QList<QIcon> &frames,
+                                           int frameIntervalMs)
+{
+    mAttentionFrames.clear();
+    for (const QIcon &frame : frames)
+        mAttentionFrames.append(iconToPixmapList(frame));
+    mAttentionFrameIndex = 0;
+
+    // Défilement local seulement si l'hôte ne joue pas le film lui-même
+    const bool cycleLocally = frameIntervalMs > 0 && mAttentionFrames.size() > 1
+            && (name.isEmpty() || !hostPlaysAttentionMovie());
+    if (cycleLocally) {
+        if (!mAttentionTimer) {
+            mAttentionTimer = new QTimer(this);
+            connect(mAttentionTimer, &QTimer::timeout, this, [this]() {
+                QPointer<StatusNotifierItem> self(this);
+                QtThreadManager::post(QtThreadManager::Lane::Background, [self]() {
+                    if (self)
+                        self->onAttentionFrame();
+                }, mAttentionTimer, 0, QtThreadManager::Entry::Tick);
+            });
+        }
+        mAttentionTimer->setInterval(frameIntervalMs);
+    } else if (mAttentionTimer) {
+        delete mAttentionTimer;
+        mAttentionTimer = nullptr;
+    }
+
+    mAttentionMovieName = name;
+
+    // Repli statique : première image comme icône d’attention
+    mAttentionIconName.clear();
+    mAttentionIconCacheKey = 0;
+    mAttentionIcon = mAttentionFrames.value(0);
+    emitChanged(AttentionIconChanged);
+
+    updateAttentionAnimation();
+}
+
+/* Le moteur local ne tourne que pendant NeedsAttention */
+void StatusNotifierItem::updateAttentionAnimation()
+{
+    if (!mAttentionTimer)
+        return;
+
+    if (mStatus == QLatin1String("NeedsAttention")) {
+        if (!mAttentionTimer->isActive())
+            mAttentionTimer->start();
+    } else if (mAttentionTimer->isActive()) {
+        mAttentionTimer->stop();
+        mAttentionFrameIndex = 0;
+    }
+}
+
+void StatusNotifierItem::onAttentionFrame()
+{
+    if (mAttentionFrames.isEmpty())
+        return;
+
+    mAttentionFrameIndex = (mAttentionFrameIndex + 1) % mAttentionFrames.size();
+    mAttentionIcon = mAttentionFrames.at(mAttentionFrameIndex);
+    emitChanged(AttentionIconChanged);
 }
 
 void StatusNotifierItem::setToolTipTitle(const QString &title)
@@ -270,7 +544,7 @@ void StatusNotifierItem::setToolTipTitle(const QString &title)
         return;
 
     mTooltipTitle = title;
-    Q_EMIT mAdaptor->NewToolTip();
+    emitChanged(ToolTipChanged);
 }
 
 void StatusNotifierItem::setToolTipSubTitle(const QString &subTitle)
@@ -279,7 +553,7 @@ void StatusNotifierItem::setToolTipSubTitle(const QString &subTitle)
         return;
 
     mTooltipSubtitle = subTitle;
-    Q_EMIT mAdaptor->NewToolTip();
+    emitChanged(ToolTipChanged);
 }
 
 void StatusNotifierItem::setToolTipIconByName(const QString &name)
@@ -290,7 +564,7 @@ void StatusNotifierItem::setToolTipIconByName(const QString &name)
     mTooltipIconName = name;
     mTooltipIcon.clear();
     mTooltipIconCacheKey = 0;
-    Q_EMIT mAdaptor->NewToolTip();
+    emitChanged(ToolTipChanged);
 }
 
 void StatusNotifierItem::setToolTipIconByPixmap(const QIcon &icon)
@@ -301,7 +575,50 @@ void StatusNotifierItem::setToolTipIconByPixmap(const QIcon &icon)
     mTooltipIconCacheKey = icon.cacheKey();
     mTooltipIcon = iconToPixmapList(icon);
     mTooltipIconName.clear();
-    Q_EMIT mAdaptor->NewToolTip();
+    emitChanged(ToolTipChanged);
+}
+
+/* ---------------------- Fournisseurs (modèle « pull ») ---------------------- */
+
+void StatusNotifierItem::setToolTipTitleProvider(std::function<QString()> provider, int ttlMs)
+{
+    mTooltipTitleProvider.provider = std::move(provider);
+    mTooltipTitleProvider.ttlMs = ttlMs;
+    mTooltipTitleProvider.invalidate();
+    emitChanged(ToolTipChanged);
+}
+
+void StatusNotifierItem::setToolTipSubTitleProvider(std::function<QString()> provider, int ttlMs)
+{
+    mTooltipSubtitleProvider.provider = std::move(provider);
+    mTooltipSubtitleProvider.ttlMs = ttlMs;
+    mTooltipSubtitleProvider.invalidate();
+    emitChanged(ToolTipChanged);
+}
+
+void StatusNotifierItem::setIconProvider(std::function<QIcon()> provider, int ttlMs)
+{
+    // mIconName est gardé : iconName() le masque tant que le fournisseur est là
+    if (provider)
+        mIconProvider.provider = [provider]() { return iconToPixmapList(provider()); };
+    else
+        mIconProvider.provider = nullptr;
+    mIconProvider.ttlMs = ttlMs;
+    mIconProvider.invalidate();
+    emitChanged(IconChanged);
+}
+
+void StatusNotifierItem::invalidateToolTip()
+{
+    mTooltipTitleProvider.invalidate();
+    mTooltipSubtitleProvider.invalidate();
+    emitChanged(ToolTipChanged);
+}
+
+void StatusNotifierItem::invalidateIcon()
+{
+    mIconProvider.invalidate();
+    emitChanged(IconChanged);
 }
 
 /* ---------------------- Attachement/détachement du menu ---------------------- */
@@ -339,17 +656,74 @@ void StatusNotifierItem::Activate(int x, int y)
 {
     if (mStatus == QLatin1String("NeedsAttention"))
         mStatus = QLatin1String("Active");
+    updateAttentionAnimation();
+
+    emitChanged(StatusChanged);
+
+    // Hôte qui ignore ItemIsMenu : ouvrir le menu sans remonter le clic
+    if (mItemIsMenu && mMenu) {
+        ContextMenu(x, y);
+        return;
+    }
+
+    if (mClickGestures) {
+        registerClick(QPoint(x, y));
+        return;
+    }
 
-    Q_EMIT mAdaptor->NewStatus(mStatus);
     Q_EMIT activateRequested(QPoint(x, y));
 }
 
+void StatusNotifierItem::setClickGestures(bool enabled, int multiClickMs, int maxClicks)
+{
+    mClickGestures = enabled;
+    mMaxClicks = qBound(1, maxClicks, 3);
+    mClickCount = 0;
+
+    if (!enabled) {
+        delete mClickTimer;
+        mClickTimer = nullptr;
+        return;
+    }
+
+    if (!mClickTimer) {
+        mClickTimer = new QTimer(this);
+        mClickTimer->setSingleShot(true);
+        connect(mClickTimer, &QTimer::timeout, this, &StatusNotifierItem::onClickBurstEnd);
+    }
+    mClickTimer->setInterval(multiClickMs > 0 ? multiClickMs
+                                              : QGuiApplication::styleHints()->mouseDoubleClickInterval());
+}
+
+void StatusNotifierItem::registerClick(const QPoint &pos)
+{
+    mClickPos = pos;
+    ++mClickCount;
+    mClickTimer->start();       // chaque clic prolonge la rafale
+
+    // Plafond atteint : inutile d’attendre la fin de la rafale
+    if (mClickCount == mMaxClicks)
+        Q_EMIT clickGestureRecognized(mClickCount, mClickCount, pos);
+    else if (mClickCount > mMaxClicks)
+        Q_EMIT clickGestureRecognized(RepeatClick, mClickCount, pos);
+}
+
+void StatusNotifierItem::onClickBurstEnd()
+{
+    const int clicks = mClickCount;
+    mClickCount = 0;
+
+    if (clicks > 0 && clicks < mMaxClicks)
+        Q_EMIT clickGestureRecognized(clicks, clicks, mClickPos);
+}
+
 void StatusNotifierItem::SecondaryActivate(int x, int y)
 {
     if (mStatus == QLatin1String("NeedsAttention"))
         mStatus = QLatin1String("Active");
+    updateAttentionAnimation();
 
-    Q_EMIT mAdaptor->NewStatus(mStatus);
+    emitChanged(StatusChanged);
     Q_EMIT secondaryActivateRequested(QPoint(x, y));
 }
 
@@ -370,20 +744,91 @@ void StatusNotifierItem::Scroll(int delta, const QString &orientation)
     if (orientation.toLower() == QLatin1String("horizontal"))
         orient = Qt::Horizontal;
 
-    Q_EMIT scrollRequested(delta, orient);
+    if (mScrollWindowMs <= 0 && mScrollNotch <= 0) {
+        Q_EMIT scrollRequested(delta, orient);
+        return;
+    }
+
+    // Changement de sens : seul le reliquat reporté est abandonné, le
+    // mouvement de la fenêtre en cours est encore à envoyer (+50 −20 → +30)
+    const int i = orient == Qt::Horizontal ? 1 : 0;
+    int &carry = mScrollCarry[i];
+    if ((carry > 0 && delta < 0) || (carry < 0 && delta > 0))
+        carry = 0;
+    mScrollAccum[i] += delta;
+
+    if (mScrollWindowMs <= 0)
+        flushScroll();
+    else if (!mScrollTimer->isActive())
+        mScrollTimer->start();
+}
+
+void StatusNotifierItem::setScrollCoalescing(int windowMs, int notch)
+{
+    mScrollWindowMs = qMax(0, windowMs);
+    mScrollNotch = qMax(0, notch);
+    mScrollAccum[0] = mScrollAccum[1] = 0;
+    mScrollCarry[0] = mScrollCarry[1] = 0;
+
+    if (mScrollWindowMs > 0) {
+        if (!mScrollTimer) {
+            mScrollTimer = new QTimer(this);
+            mScrollTimer->setSingleShot(true);
+            mScrollTimer->setTimerType(Qt::PreciseTimer);
+            connect(mScrollTimer, &QTimer::timeout, this, &StatusNotifierItem::flushScroll);
+        }
+        mScrollTimer->setInterval(mScrollWindowMs);
+    } else if (mScrollTimer) {
+        delete mScrollTimer;
+        mScrollTimer = nullptr;
+    }
+}
+
+void StatusNotifierItem::flushScroll()
+{
+    static const Qt::Orientation orientations[2] = { Qt::Vertical, Qt::Horizontal };
+
+    for (int i = 0; i < 2; ++i) {
+        const int total = mScrollCarry[i] + mScrollAccum[i];
+        int delta = total;
+        if (mScrollNotch > 0)
+            delta = delta / mScrollNotch * mScrollNotch;   // crans entiers, vers zéro
+        mScrollAccum[i] = 0;
+        mScrollCarry[i] = total - delta;
+        if (delta == 0)
+            continue;
+        Q_EMIT scrollRequested(delta, orientations[i]);
+    }
 }
 
 /* ---------------------- Divers utilitaires ---------------------- */
 
 void StatusNotifierItem::showMessage(const QString& title, const QString& msg,
                                      const QString& iconName, int secs)
+{
+    showMessage(title, msg, iconName, secs, nullptr);
+}
+
+void StatusNotifierItem::showMessage(const QString& title, const QString& msg,
+                                     const QString& iconName, int secs,
+                                     std::function<void(quint32)> onReply)
 {
     QDBusInterface interface(QLatin1String("org.freedesktop.Notifications"),
                              QLatin1String("/org/freedesktop/Notifications"),
                              QLatin1String("org.freedesktop.Notifications"),
                              mSessionBus);
-    interface.call(QLatin1String("Notify"), mTitle, (uint)0, iconName, title,
-                   msg, QStringList(), QVariantMap(), secs);
+    QDBusPendingCall call = interface.asyncCall(QLatin1String("Notify"), mTitle, (uint)0, iconName,
+                                                title, msg, QStringList(), QVariantMap(), secs);
+    if (!onReply)
+        return;
+
+    auto *watcher = new QDBusPendingCallWatcher(call, this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this,
+            [onReply](QDBusPendingCallWatcher *call) {
+                call->deleteLater();
+                QDBusPendingReply<quint32> reply = *call;
+                onReply(reply.isError() ? 0 : reply.value());
+            });
 }
 
 IconPixmapList StatusNotifierItem::iconToPixmapList(const QIcon &icon)
@@ -450,7 +895,7 @@ void StatusNotifierItem::unregister()
 
 void StatusNotifierItem::forceUpdate()
 {
-    Q_EMIT mAdaptor->NewIcon();
-    Q_EMIT mAdaptor->NewToolTip();
-    Q_EMIT mAdaptor->NewStatus(mStatus);
+    emitChanged(IconChanged);
+    emitChanged(ToolTipChanged);
+    emitChanged(StatusChanged);
 }
@@ -0,0 +1,123 @@
+#include "svgrasterizer.h"
+
+#include <QCryptographicHash>
+#include <QHash>
+#include <QImage>
+#include <QPainter>
+#include <QSvgRenderer>
+#include <QtConcurrent>
+#include <QtEndian>
+
+// Coût = octets ARGB ; ~4 Mo de rendus conservés
+static const int kRasterCacheBytes = 4 * 1024 * 1024;
+
+SvgRasterizer &SvgRasterizer::instance()
+{
+    static SvgRasterizer rasterizer;
+    return rasterizer;
+}
+
+SvgRasterizer::SvgRasterizer()
+    : mCache(kRasterCacheBytes)
+{
+}
+
+bool SvgRasterizer::isSvg(const QByteArray &data, const QByteArray &formatHint)
+{
+    const QByteArray hint = formatHint.toLower();
+    if (hint == "svg" || hint == "svgz" || hint == "image/svg+xml")
+        return true;
+
+    // gzip (svgz) sans indice : laisser QImageReader décider
+    return data.left(4096).contains("<svg");
+}
+
+/* Rendu d'une taille : le renderer est propre à la tâche (QSvgRenderer
+ * n'est pas partageable entre threads) */
+static IconPixmap renderSize(const QByteArray &svg, int side)
+{
+    IconPixmap p;
+    p.width  = 0;
+    p.height = 0;
+
+    QSvgRenderer renderer(svg);
+    if (!renderer.isValid())
+        return p;
+
+    QImage img(side, side, QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::transparent);
+    {
+        QPainter painter(&img);
+        painter.setRenderHint(QPainter::Antialiasing);
+        // Comme QIcon : proportions conservées, centré dans le carré
+        QSizeF size = renderer.defaultSize();
+        if (size.isEmpty())
+            size = renderer.viewBoxF().size();
+        if (size.isEmpty())
+            size = QSizeF(side, side);
+        size.scale(side, side, Qt::KeepAspectRatio);
+        renderer.render(&painter, QRectF(QPointF((side - size.width()) / 2, (side - size.height()) / 2),
+                                         size));
+    }
+    img = img.convertToFormat(QImage::Format_ARGB32);
+
+    p.width  = side;
+    p.height = side;
+    p.bytes.resize(side * side * 4);
+    auto *out = reinterpret_cast<quint32 *>(p.bytes.data());
+    for (int y = 0; y < side; ++y) {
+        const auto *line = reinterpret_cast<const quint32 *>(img.constScanLine(y));
+        for (int x = 0; x < side; ++x)
+            *out++ = qToBigEndian(line[x]);
+    }
+    return p;
+}
+
+/* Foncteur pour QtConcurrent (result_type requis par Qt 5) */
+struct RenderJob
+{
+    typedef IconPixmap result_type;
+    QByteArray svg;
+    IconPixmap operator()(int side) const { return renderSize(svg, side); }
+};
+
+IconPixmapList SvgRasterizer::rasterize(const QByteArray &svg, const QList<int> &sizes, qreal scale)
+{
+    const QByteArray hash = QCryptographicHash::hash(svg, QCryptographicHash::Md5);
+    auto keyFor = [&hash, scale](int side) {
+        return hash + QByteArray::number(side) + '@' + QByteArray::number(scale);
+    };
+
+    QList<int> missing;
+    for (int size : sizes) {
+        const int side = qRound(size * scale);
+        if (side > 0 && !mCache.contains(keyFor(side)) && !missing.contains(side))
+            missing.append(side);
+    }
+
+    // Une seule taille : inutile de passer par le pool de threads
+    QList<IconPixmap> rendered;
+    if (missing.size() == 1)
+        rendered.append(renderSize(svg, missing.first()));
+    else if (!missing.isEmpty())
+        rendered = QtConcurrent::blockingMapped<QList<IconPixmap>>(missing, RenderJob { svg });
+
+    QHash<int, IconPixmap> fresh;
+    for (int i = 0; i < missing.size(); ++i) {
+        const IconPixmap &p = rendered.at(i);
+        if (p.width <= 0)
+            continue;
+        fresh.insert(missing.at(i), p);
+        mCache.insert(keyFor(missing.at(i)), new IconPixmap(p), p.bytes.size());
+    }
+
+    IconPixmapList list;
+    for (int size : sizes) {
+        const int side = qRound(size * scale);
+        if (fresh.contains(side))
+            list.append(fresh.value(side));
+        else if (IconPixmap *p = mCache.object(keyFor(side)))
+            list.append(*p);
+    }
+    return list;
+}
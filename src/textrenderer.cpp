@@ -0,0 +1,260 @@
+#include "textrenderer.h"
+
+#include <QFontMetrics>
+#include <QGuiApplication>
+#include <QPainter>
+
+#include <cstring>
+
+static const int kAtlasWidth  = 256;
+static const int kMaxAtlases  = 16;
+static const int kRecentTexts = 64;
+static const int kMinPixelSize = 6;
+
+/* « Famille[:bold] » → QFont ; vide = police de l'application */
+static QFont parseFontSpec(const QString &spec)
+{
+    QFont font = QGuiApplication::font();
+    QString family = spec.trimmed();
+    if (family.endsWith(QLatin1String(":bold"), Qt::CaseInsensitive)) {
+        family.chop(5);
+        font.setBold(true);
+    }
+    if (!family.isEmpty())
+        font.setFamily(family);
+    font.setStyleStrategy(QFont::PreferAntialias);
+    return font;
+}
+
+/* Boîte d'encre et avance d'un code point, comme GlyphAtlas::glyph() les mesure */
+static QRect glyphInk(const QFontMetrics &fm, const QString &s, int *advance)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
+    *advance = fm.horizontalAdvance(s);
+#else
+    *advance = fm.width(s);
+#endif
+    const QRect ink = fm.boundingRect(s).adjusted(-1, -1, 1, 1);
+    return QRect(ink.x(), ink.y(), qMin(ink.width(), kAtlasWidth), ink.height());
+}
+
+/* Mesure seule, sans rastériser ni créer d'atlas */
+static QRect measureInk(const QFont &font, const QVector<uint> &text)
+{
+    const QFontMetrics fm(font);
+    QRect box;
+    int penX = 0;
+    for (uint c : text) {
+        int advance = 0;
+        const QRect ink = glyphInk(fm, QString::fromUcs4(&c, 1), &advance);
+        if (ink.width() > 0 && ink.height() > 0)
+            box |= ink.translated(penX, 0);
+        penX += advance;
+    }
+    return box;
+}
+
+/* ---------------------- Atlas de glyphes ---------------------- */
+
+TextIconRenderer::GlyphAtlas::GlyphAtlas(const QFont &font)
+    : mFont(font),
+      mMask(kAtlasWidth, 32, QImage::Format_Alpha8)
+{
+    mMask.fill(0);
+}
+
+const TextIconRenderer::Glyph &TextIconRenderer::GlyphAtlas::glyph(uint ucs4)
+{
+    auto it = mGlyphs.constFind(ucs4);
+    if (it != mGlyphs.constEnd())
+        return *it;
+
+    const QString s = QString::fromUcs4(&ucs4, 1);
+    Glyph g;
+    const QRect ink = glyphInk(QFontMetrics(mFont), s, &g.advance);
+    g.left   = ink.x();
+    g.top    = ink.y();
+    g.width  = ink.width();
+    g.height = ink.height();
+
+    if (g.width > 0 && g.height > 0) {
+        // Rendu une seule fois par Qt, puis seul l'alpha est conservé
+        QImage scratch(g.width, g.height, QImage::Format_ARGB32_Premultiplied);
+        scratch.fill(Qt::transparent);
+        {
+            QPainter p(&scratch);
+            p.setFont(mFont);
+            p.setPen(Qt::white);
+            p.drawText(-g.left, -g.top, s);
+        }
+
+        if (mPenX + g.width > kAtlasWidth) {
+            mPenX = 0;
+            mPenY += mRowHeight;
+            mRowHeight = 0;
+        }
+        if (mPenY + g.height > mMask.height()) {
+            QImage grown(kAtlasWidth, qMax(mMask.height() * 2, mPenY + g.height),
+                         QImage::Format_Alpha8);
+            grown.fill(0);
+            for (int y = 0; y < mMask.height(); ++y)
+                std::memcpy(grown.scanLine(y), mMask.constScanLine(y), kAtlasWidth);
+            mMask = grown;
+        }
+
+        g.x = mPenX;
+        g.y = mPenY;
+        for (int y = 0; y < g.height; ++y) {
+            const QRgb *src = reinterpret_cast<const QRgb *>(scratch.constScanLine(y));
+            uchar *dst = mMask.scanLine(g.y + y) + g.x;
+            for (int x = 0; x < g.width; ++x)
+                dst[x] = uchar(qAlpha(src[x]));
+        }
+        mPenX += g.width;
+        mRowHeight = qMax(mRowHeight, g.height);
+    } else {
+        g.width = g.height = 0;
+    }
+
+    return *mGlyphs.insert(ucs4, g);
+}
+
+/* ---------------------- Rendu ---------------------- */
+
+TextIconRenderer &TextIconRenderer::instance()
+{
+    static TextIconRenderer renderer;
+    return renderer;
+}
+
+TextIconRenderer::TextIconRenderer()
+    : mAtlases(kMaxAtlases),
+      mRecent(kRecentTexts)
+{
+}
+
+TextIconRenderer::GlyphAtlas *TextIconRenderer::atlas(const QFont &base, int pixelSize)
+{
+    const QString key = base.key() + QLatin1Char('@') + QString::number(pixelSize);
+    if (GlyphAtlas *hit = mAtlases.object(key))
+        return hit;
+
+    QFont font(base);
+    font.setPixelSize(pixelSize);
+    GlyphAtlas *created = new GlyphAtlas(font);
+    mAtlases.insert(key, created);
+    return created;
+}
+
+QRect TextIconRenderer::inkBox(GlyphAtlas *atlas, const QVector<uint> &text)
+{
+    QRect box;
+    int penX = 0;
+    for (uint c : text) {
+        const Glyph &g = atlas->glyph(c);
+        if (g.width > 0)
+            box |= QRect(penX + g.left, g.top, g.width, g.height);
+        penX += g.advance;
+    }
+    return box;
+}
+
+IconPixmap TextIconRenderer::renderSize(const QFont &base, const QVector<uint> &text, int side,
+                                        quint32 fgArgb, quint32 bgArgb)
+{
+    const int margin = side / 16;
+    const int avail = side - 2 * margin;
+
+    // Taille de police ajustée à la boîte d'encre : les essais ne font que
+    // mesurer, seul l'atlas de la taille retenue est construit
+    QFont font(base);
+    font.setPixelSize(avail);
+    QRect box = measureInk(font, text);
+    int pixelSize = avail;
+    if (!box.isEmpty()) {
+        const qreal fit = qMin(qreal(avail) / box.width(), qreal(avail) / box.height());
+        pixelSize = qMax(kMinPixelSize, int(avail * fit));
+        font.setPixelSize(pixelSize);
+        box = measureInk(font, text);
+        while (pixelSize > kMinPixelSize && (box.width() > avail || box.height() > avail)) {
+            font.setPixelSize(--pixelSize);
+            box = measureInk(font, text);
+        }
+    }
+    GlyphAtlas *glyphs = atlas(base, pixelSize);
+    box = inkBox(glyphs, text);
+
+    // Tampon ARGB non prémultiplié, fond uni éventuel
+    QVector<quint32> canvas(side * side, (bgArgb >> 24) ? bgArgb : 0u);
+    const int originX = (side - box.width()) / 2 - box.x();
+    const int originY = (side - box.height()) / 2 - box.y();
+    const quint32 fgA = fgArgb >> 24;
+    const quint32 fgRgb = fgArgb & 0xffffffu;
+
+    int penX = originX;
+    for (uint c : text) {
+        const Glyph &g = glyphs->glyph(c);
+        for (int row = 0; row < g.height; ++row) {
+            const int y = originY + g.top + row;
+            if (y < 0 || y >= side)
+                continue;
+            const uchar *mask = glyphs->mask(g, row);
+            quint32 *line = canvas.data() + y * side;
+            for (int col = 0; col < g.width; ++col) {
+                const int x = penX + g.left + col;
+                if (x < 0 || x >= side || !mask[col])
+                    continue;
+                const quint32 sa = (mask[col] * fgA + 127) / 255;
+                const quint32 dst = line[x];
+                const quint32 da = dst >> 24;
+                // « source over » en alpha droit
+                const quint32 oa = sa + (da * (255 - sa) + 127) / 255;
+                if (!oa)
+                    continue;
+                quint32 out = oa << 24;
+                for (int shift = 0; shift <= 16; shift += 8) {
+                    const quint32 sc = (fgRgb >> shift) & 0xffu;
+                    const quint32 dc = (dst >> shift) & 0xffu;
+                    const quint32 oc = (sc * sa * 255 + dc * da * (255 - sa) + oa * 127) / (oa * 255);
+                    out |= qMin(oc, 255u) << shift;
+                }
+                line[x] = out;
+            }
+        }
+        penX += g.advance;
+    }
+
+    IconPixmap pix;
+    pix.width = side;
+    pix.height = side;
+    pix.bytes.resize(side * side * 4);
+    uchar *out = reinterpret_cast<uchar *>(pix.bytes.data());
+    for (quint32 px : canvas) {
+        out[0] = uchar(px >> 24);
+        out[1] = uchar(px >> 16);
+        out[2] = uchar(px >> 8);
+        out[3] = uchar(px);
+        out += 4;
+    }
+    return pix;
+}
+
+CachedIcon TextIconRenderer::render(const QString &text, const QString &fontSpec,
+                                    quint32 fgArgb, quint32 bgArgb)
+{
+    const QString key = text + QLatin1Char('\x1f') + fontSpec + QLatin1Char('\x1f')
+                      + QString::number(fgArgb, 16) + QLatin1Char('/') + QString::number(bgArgb, 16);
+    if (CachedIcon *hit = mRecent.object(key))
+        return *hit;
+
+    const QFont base = parseFontSpec(fontSpec);
+    const QVector<uint> codePoints = text.toUcs4();
+
+    CachedIcon icon;
+    icon.key = IconCache::nextKey();
+    for (int side : IconCache::standardSizes())
+        icon.pixmaps.append(renderSize(base, codePoints, side, fgArgb, bgArgb));
+
+    mRecent.insert(key, new CachedIcon(icon));
+    return icon;
+}
@@ -0,0 +1,279 @@
+#include "trayevents.h"
+#include "statusnotifieritem.h"
+
+#include <QList>
+#include <QMutexLocker>
+#include <QPair>
+#include <QPoint>
+
+#include <cstring>
+
+QMutex TrayEventRing::sLock;
+QHash<StatusNotifierItem*, TrayEventRing*> TrayEventRing::sRings;
+QHash<void*, Qt::HANDLE> TrayEventRing::sFiring;
+QWaitCondition TrayEventRing::sFired;
+
+QMutex TrayReplies::sLock;
+QHash<void*, TrayReplies::Pending> TrayReplies::sPending;
+quint64 TrayReplies::sSerial = 0;
+QHash<void*, Qt::HANDLE> TrayReplies::sFiring;
+QWaitCondition TrayReplies::sFired;
+
+/* Attend la fin d'un rappel en vol pour `data`, sauf depuis ce rappel même */
+static void waitFired(QMutex *lock, QWaitCondition *fired, const QHash<void*, Qt::HANDLE> &firing, void *data)
+{
+    for (;;) {
+        auto it = firing.constFind(data);
+        if (it == firing.constEnd() || it.value() == QThread::currentThreadId())
+            return;
+        fired->wait(lock);
+    }
+}
+
+static sni_event makeEvent(int type)
+{
+    sni_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.type = type;
+    return event;
+}
+
+void TrayEventRing::install(StatusNotifierItem *sni, int capacity)
+{
+    forget(sni);
+    if (capacity > 0)
+        new TrayEventRing(sni, capacity);
+}
+
+void TrayEventRing::forget(StatusNotifierItem *sni)
+{
+    TrayEventRing *ring;
+    {
+        QMutexLocker lock(&sLock);
+        ring = sRings.value(sni);
+    }
+    delete ring;
+}
+
+TrayEventRing::TrayEventRing(StatusNotifierItem *sni, int capacity)
+    : QObject(sni),
+      mSni(sni),
+      mRing(capacity),
+      mHead(0),
+      mCount(0),
+      mDropped(0),
+      mWaitOut(nullptr),
+      mWaitCb(nullptr),
+      mWaitData(nullptr)
+{
+    connect(sni, &StatusNotifierItem::activateRequested, this, [this](const QPoint &pos) {
+        sni_event event = makeEvent(SNI_EVENT_ACTIVATE);
+        event.x = pos.x();
+        event.y = pos.y();
+        push(event);
+    }, Qt::DirectConnection);
+    connect(sni, &StatusNotifierItem::secondaryActivateRequested, this, [this](const QPoint &pos) {
+        sni_event event = makeEvent(SNI_EVENT_SECONDARY_ACTIVATE);
+        event.x = pos.x();
+        event.y = pos.y();
+        push(event);
+    }, Qt::DirectConnection);
+    connect(sni, &StatusNotifierItem::scrollRequested, this, [this](int delta, Qt::Orientation orientation) {
+        sni_event event = makeEvent(SNI_EVENT_SCROLL);
+        event.delta = delta;
+        event.orientation = orientation == Qt::Horizontal ? 1 : 0;
+        push(event);
+    }, Qt::DirectConnection);
+    connect(sni, &StatusNotifierItem::clickGestureRecognized, this,
+            [this](int gesture, int clicks, const QPoint &pos) {
+        sni_event event = makeEvent(SNI_EVENT_CLICK_GESTURE);
+        event.gesture = gesture;
+        event.clicks = clicks;
+        event.x = pos.x();
+        event.y = pos.y();
+        push(event);
+    }, Qt::DirectConnection);
+    connect(sni, &StatusNotifierItem::registrationFinished, this, [this](bool registered) {
+        sni_event event = makeEvent(SNI_EVENT_REGISTERED);
+        event.registered = registered ? 1 : 0;
+        push(event);
+    }, Qt::DirectConnection);
+
+    QMutexLocker lock(&sLock);
+    sRings.insert(sni, this);
+}
+
+TrayEventRing::~TrayEventRing()
+{
+    EventReadyCallback cb;
+    void *data;
+    {
+        QMutexLocker lock(&sLock);
+        sRings.remove(mSni);
+        cb = mWaitCb;
+        data = mWaitData;
+        if (mWaitOut)
+            *mWaitOut = makeEvent(SNI_EVENT_CLOSED);
+        mWaitOut = nullptr;
+        mWaitCb = nullptr;
+        if (cb)
+            sFiring.insert(data, QThread::currentThreadId());
+    }
+    if (cb)
+        fire(cb, data);
+}
+
+void TrayEventRing::fire(EventReadyCallback cb, void *data)
+{
+    cb(data);
+    QMutexLocker lock(&sLock);
+    sFiring.remove(data);
+    sFired.wakeAll();
+}
+
+void TrayEventRing::push(const sni_event &event)
+{
+    EventReadyCallback cb = nullptr;
+    void *data = nullptr;
+    {
+        QMutexLocker lock(&sLock);
+        if (mWaitOut) {
+            // Ring vide par construction : l'attente ne s'arme que dans ce cas
+            *mWaitOut = event;
+            mWaitOut->dropped = mDropped;
+            mDropped = 0;
+            cb = mWaitCb;
+            data = mWaitData;
+            mWaitOut = nullptr;
+            mWaitCb = nullptr;
+            sFiring.insert(data, QThread::currentThreadId());
+        } else {
+            const int capacity = mRing.size();
+            if (mCount == capacity) {
+                // Perte reportée sur le nouvel événement le plus ancien
+                const unsigned int lost = mRing[mHead].dropped + 1;
+                mHead = (mHead + 1) % capacity;
+                if (--mCount > 0)
+                    mRing[mHead].dropped += lost;
+                else
+                    mDropped += lost;
+            }
+            sni_event &slot = mRing[(mHead + mCount) % capacity];
+            slot = event;
+            slot.dropped = mDropped;
+            mDropped = 0;
+            ++mCount;
+        }
+    }
+    if (cb)
+        fire(cb, data);
+}
+
+bool TrayEventRing::popLocked(sni_event *out)
+{
+    if (mCount == 0)
+        return false;
+    *out = mRing[mHead];
+    mHead = (mHead + 1) % mRing.size();
+    --mCount;
+    return true;
+}
+
+bool TrayEventRing::poll(StatusNotifierItem *sni, sni_event *out)
+{
+    QMutexLocker lock(&sLock);
+    TrayEventRing *ring = sRings.value(sni);
+    return ring && ring->popLocked(out);
+}
+
+int TrayEventRing::next(StatusNotifierItem *sni, sni_event *out, EventReadyCallback cb, void *data)
+{
+    QMutexLocker lock(&sLock);
+    TrayEventRing *ring = sRings.value(sni);
+    if (!ring || ring->mWaitOut)
+        return -1;
+    if (ring->popLocked(out))
+        return 1;
+
+    ring->mWaitOut = out;
+    ring->mWaitCb = cb;
+    ring->mWaitData = data;
+    return 0;
+}
+
+bool TrayEventRing::cancel(StatusNotifierItem *sni, void *data)
+{
+    QMutexLocker lock(&sLock);
+    TrayEventRing *ring = sRings.value(sni);
+    if (!ring || !ring->mWaitOut || ring->mWaitData != data) {
+        // Trop tard : rendre la main seulement une fois le rappel terminé
+        waitFired(&sLock, &sFired, sFiring, data);
+        return false;
+    }
+    ring->mWaitOut = nullptr;
+    ring->mWaitCb = nullptr;
+    ring->mWaitData = nullptr;
+    return true;
+}
+
+/* ---------------------- TrayReplies ---------------------- */
+
+quint64 TrayReplies::begin(StatusNotifierItem *sni, AsyncReplyCallback cb, void *data)
+{
+    QMutexLocker lock(&sLock);
+    const quint64 serial = ++sSerial;
+    sPending.insert(data, Pending{sni, cb, serial});
+    return serial;
+}
+
+void TrayReplies::finish(void *data, quint64 serial, unsigned int result)
+{
+    AsyncReplyCallback cb;
+    {
+        QMutexLocker lock(&sLock);
+        auto it = sPending.find(data);
+        // Une réponse annulée ne doit pas compléter un appel suivant au même `data`
+        if (it == sPending.end() || it->serial != serial)
+            return;
+        cb = it->cb;
+        sPending.erase(it);
+        sFiring.insert(data, QThread::currentThreadId());
+    }
+    fire(cb, result, data);
+}
+
+void TrayReplies::fire(AsyncReplyCallback cb, unsigned int result, void *data)
+{
+    cb(result, data);
+    QMutexLocker lock(&sLock);
+    sFiring.remove(data);
+    sFired.wakeAll();
+}
+
+bool TrayReplies::cancel(void *data)
+{
+    QMutexLocker lock(&sLock);
+    if (sPending.remove(data) > 0)
+        return true;
+    waitFired(&sLock, &sFired, sFiring, data);
+    return false;
+}
+
+void TrayReplies::abandon(StatusNotifierItem *sni)
+{
+    QList<QPair<void*, AsyncReplyCallback>> orphans;
+    {
+        QMutexLocker lock(&sLock);
+        for (auto it = sPending.begin(); it != sPending.end();) {
+            if (it->sni == sni) {
+                orphans.append(qMakePair(it.key(), it->cb));
+                sFiring.insert(it.key(), QThread::currentThreadId());
+                it = sPending.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (const auto &orphan : orphans)
+        fire(orphan.second, 0, orphan.first);
+}
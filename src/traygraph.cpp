@@ -0,0 +1,252 @@
+#include "traygraph.h"
+#include "statusnotifieritem.h"
+#include "iconcache.h"
+#include "qtthreadmanager.h"
+
+#include <QMutexLocker>
+#include <QPointer>
+
+#include <cmath>
+#include <cstring>
+
+// Distincte des clés (tray, propriété) du wrapper, toutes positives
+static const int kFlushKey = -1;
+
+QMutex TrayGraph::sLock;
+QHash<StatusNotifierItem*, TrayGraph*> TrayGraph::sGraphs;
+
+/* 0xAARRGGBB → octets A R G B du fil */
+static inline void toWire(quint32 argb, uchar out[4])
+{
+    out[0] = uchar(argb >> 24);
+    out[1] = uchar(argb >> 16);
+    out[2] = uchar(argb >> 8);
+    out[3] = uchar(argb);
+}
+
+static int ringCapacity()
+{
+    int side = 0;
+    for (int s : IconCache::standardSizes())
+        side = qMax(side, s);
+    return side;
+}
+
+TrayGraph *TrayGraph::ensure(StatusNotifierItem *sni)
+{
+    {
+        QMutexLocker lock(&sLock);
+        if (TrayGraph *graph = sGraphs.value(sni))
+            return graph;
+    }
+
+    TrayGraph *graph = new TrayGraph(sni);
+    QMutexLocker lock(&sLock);
+    sGraphs.insert(sni, graph);
+    return graph;
+}
+
+void TrayGraph::forget(StatusNotifierItem *sni)
+{
+    TrayGraph *graph;
+    {
+        QMutexLocker lock(&sLock);
+        graph = sGraphs.value(sni);
+    }
+    delete graph;
+}
+
+bool TrayGraph::push(StatusNotifierItem *sni, float sample)
+{
+    {
+        QMutexLocker lock(&sLock);
+        TrayGraph *graph = sGraphs.value(sni);
+        if (!graph)
+            return false;
+
+        // Au-delà d'une largeur d'icône, les plus anciens ne seraient jamais vus
+        if (graph->mPending.size() >= graph->mRing.size())
+            graph->mPending.remove(0);
+        graph->mPending.append(sample);
+
+        if (graph->mScheduled)
+            return true;
+        graph->mScheduled = true;
+    }
+
+    // Hors du verrou. Clé sur le tray et non sur le graphe : le graphe est
+    // retrouvé dans le thread Qt, il a pu être remplacé entre-temps
+    const bool posted = QtThreadManager::post(QtThreadManager::Lane::Background, [sni]() {
+        TrayGraph *target;
+        {
+            QMutexLocker lock(&sLock);
+            target = sGraphs.value(sni);
+        }
+        if (target)
+            target->flush();
+    }, sni, kFlushKey, QtThreadManager::Entry::Tick);
+
+    if (!posted) {
+        QMutexLocker lock(&sLock);
+        if (TrayGraph *target = sGraphs.value(sni))
+            target->mScheduled = false;
+    }
+    return true;
+}
+
+TrayGraph::TrayGraph(StatusNotifierItem *sni)
+    : QObject(sni),
+      mSni(sni),
+      mRing(ringCapacity(), 0.f),
+      mHead(0),
+      mCount(0),
+      mNewColumns(0),
+      mFullRedraw(true),
+      mLo(0.f),
+      mHi(1.f),
+      mFront(0),
+      mKey(IconCache::nextKey()),
+      mScheduled(false)
+{
+    for (IconPixmapList &frames : mFrames) {
+        for (int side : IconCache::standardSizes()) {
+            IconPixmap frame;
+            frame.width = side;
+            frame.height = side;
+            frame.bytes.resize(side * side * 4);
+            frames.append(frame);
+        }
+    }
+
+    mThrottle.setSingleShot(true);
+    connect(&mThrottle, &QTimer::timeout, this, [this]() {
+        QPointer<TrayGraph> self(this);
+        QtThreadManager::post(QtThreadManager::Lane::Background, [self]() {
+            if (self)
+                self->render();
+        }, this, 1, QtThreadManager::Entry::Tick);
+    });
+}
+
+TrayGraph::~TrayGraph()
+{
+    QtThreadManager::purge(this);
+    QMutexLocker lock(&sLock);
+    sGraphs.remove(mSni);
+}
+
+void TrayGraph::setStyle(const Style &style)
+{
+    mStyle = style;
+    mFullRedraw = true;
+    if (mCount > 0)
+        render();
+}
+
+void TrayGraph::flush()
+{
+    QVector<float> fresh;
+    {
+        QMutexLocker lock(&sLock);
+        fresh.swap(mPending);
+        mScheduled = false;
+    }
+    if (fresh.isEmpty())
+        return;
+
+    for (float v : fresh) {
+        mRing[mHead] = v;
+        mHead = (mHead + 1) % mRing.size();
+    }
+    mCount = qMin(mCount + fresh.size(), mRing.size());
+    mNewColumns += fresh.size();
+
+    // Plafond de rafraîchissement : les échantillons s'accumulent entre deux images
+    const int interval = 1000 / qMax(1, mStyle.maxFps);
+    if (mLastRender.isValid() && mLastRender.elapsed() < interval) {
+        if (!mThrottle.isActive())
+            mThrottle.start(int(interval - mLastRender.elapsed()));
+        return;
+    }
+    render();
+}
+
+float TrayGraph::sampleAt(int age) const
+{
+    const int cap = mRing.size();
+    return mRing[(mHead - 1 - age + 2 * cap) % cap];
+}
+
+bool TrayGraph::updateRange()
+{
+    float lo = mStyle.min, hi = mStyle.max;
+    if (lo >= hi) {
+        lo = hi = mCount ? sampleAt(0) : 0.f;
+        for (int age = 1; age < mCount; ++age) {
+            lo = qMin(lo, sampleAt(age));
+            hi = qMax(hi, sampleAt(age));
+        }
+        if (hi - lo < 1e-6f)
+            hi = lo + 1.f;
+    }
+    const bool changed = (lo != mLo || hi != mHi);
+    mLo = lo;
+    mHi = hi;
+    return changed;
+}
+
+void TrayGraph::drawColumn(uchar *pixels, int side, int x, int age)
+{
+    uchar bg[4], line[4], fill[4];
+    toWire(mStyle.bg, bg);
+    toWire(mStyle.line, line);
+    toWire(mStyle.fill, fill);
+
+    // Colonne vide tant que l'historique est plus court que l'icône
+    int top = side;
+    if (age < mCount) {
+        float t = (sampleAt(age) - mLo) / (mHi - mLo);
+        t = qBound(0.f, t, 1.f);
+        top = qMin(side - 1, side - int(std::lround(t * side)));
+    }
+
+    uchar *px = pixels + x * 4;
+    const int stride = side * 4;
+    for (int y = 0; y < side; ++y, px += stride)
+        std::memcpy(px, y < top ? bg : (y == top ? line : fill), 4);
+}
+
+void TrayGraph::render()
+{
+    mThrottle.stop();
+    if (mNewColumns == 0 && !mFullRedraw)
+        return;
+
+    if (updateRange())
+        mFullRedraw = true;
+
+    // Le tray a rendu le tampon arrière en recevant l'avant : data() ne copie pas
+    const IconPixmapList &front = mFrames[mFront];
+    IconPixmapList &back = mFrames[1 - mFront];
+    for (int i = 0; i < back.size(); ++i) {
+        const int side = back[i].width;
+        const int shift = mFullRedraw ? side : qMin(mNewColumns, side);
+        const uchar *src = reinterpret_cast<const uchar *>(front[i].bytes.constData());
+        uchar *dst = reinterpret_cast<uchar *>(back[i].bytes.data());
+
+        if (shift < side) {
+            for (int y = 0; y < side; ++y) {
+                const size_t row = size_t(y) * side * 4;
+                std::memcpy(dst + row, src + row + shift * 4, size_t(side - shift) * 4);
+            }
+        }
+        for (int x = side - shift; x < side; ++x)
+            drawColumn(dst, side, x, side - 1 - x);
+    }
+
+    mFront = 1 - mFront;
+    mNewColumns = 0;
+    mFullRedraw = false;
+    mLastRender.restart();
+    mSni->setIconFrame(mFrames[mFront], mKey);
+}
@@ -0,0 +1,67 @@
+#include "traygroup.h"
+#include "statusnotifieritem.h"
+
+#include <QMutexLocker>
+
+void TrayGroup::add(StatusNotifierItem *sni)
+{
+    QMutexLocker lock(&mLock);
+    for (const QPointer<StatusNotifierItem> &member : mMembers) {
+        if (member == sni)
+            return;
+    }
+    mMembers.append(sni);
+}
+
+void TrayGroup::remove(StatusNotifierItem *sni)
+{
+    QMutexLocker lock(&mLock);
+    for (int i = mMembers.size() - 1; i >= 0; --i) {
+        // Nettoie aussi les membres déjà détruits
+        if (mMembers[i] == sni || mMembers[i].isNull())
+            mMembers.removeAt(i);
+    }
+}
+
+void TrayGroup::begin()
+{
+    QMutexLocker lock(&mLock);
+    mBatching = true;
+}
+
+bool TrayGroup::defer(const Change &change)
+{
+    QMutexLocker lock(&mLock);
+    if (!mBatching)
+        return false;
+    mPending.append(change);
+    return true;
+}
+
+QList<TrayGroup::Change> TrayGroup::takePending()
+{
+    QMutexLocker lock(&mLock);
+    mBatching = false;
+    QList<Change> pending;
+    pending.swap(mPending);
+    return pending;
+}
+
+void TrayGroup::apply(const QList<Change> &changes)
+{
+    QList<QPointer<StatusNotifierItem>> members;
+    {
+        QMutexLocker lock(&mLock);
+        members = mMembers;
+    }
+
+    for (const QPointer<StatusNotifierItem> &member : members) {
+        StatusNotifierItem *sni = member.data();
+        if (!sni)
+            continue;
+        sni->beginUpdate();
+        for (const Change &change : changes)
+            change(sni);
+        sni->endUpdate();
+    }
+}
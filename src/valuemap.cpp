@@ -0,0 +1,82 @@
+#include "valuemap.h"
+#include "statusnotifieritem.h"
+#include "iconcache.h"
+
+#include <algorithm>
+
+TrayValueMap *TrayValueMap::install(StatusNotifierItem *sni, const QVector<double> &thresholds,
+                                    const QVector<SharedIcon*> &icons, double hysteresis)
+{
+    forget(sni);
+    return new TrayValueMap(sni, thresholds, icons, hysteresis);
+}
+
+TrayValueMap *TrayValueMap::of(StatusNotifierItem *sni)
+{
+    return sni->findChild<TrayValueMap *>(QString(), Qt::FindDirectChildrenOnly);
+}
+
+void TrayValueMap::forget(StatusNotifierItem *sni)
+{
+    delete of(sni);
+}
+
+TrayValueMap::TrayValueMap(StatusNotifierItem *sni, const QVector<double> &thresholds,
+                           const QVector<SharedIcon*> &icons, double hysteresis)
+    : QObject(sni),
+      mSni(sni),
+      mThresholds(thresholds),
+      mIcons(icons),
+      mHysteresis(qMax(0.0, hysteresis)),
+      mBucket(-1)
+{
+    for (SharedIcon *icon : mIcons)
+        icon->ref();
+}
+
+TrayValueMap::~TrayValueMap()
+{
+    for (SharedIcon *icon : mIcons)
+        icon->deref();
+}
+
+int TrayValueMap::lookup(double value) const
+{
+    const auto it = std::upper_bound(mThresholds.constBegin(), mThresholds.constEnd(), value);
+    return qMax(0, int(it - mThresholds.constBegin()) - 1);
+}
+
+void TrayValueMap::setValue(double value)
+{
+    if (mThresholds.isEmpty())
+        return;
+
+    // Hystérésis : on ne quitte le seau courant qu'au-delà de ses bornes ± h
+    if (mBucket >= 0) {
+        const bool belowLow = mBucket > 0
+                && value < mThresholds[mBucket] - mHysteresis;
+        const bool aboveHigh = mBucket + 1 < mThresholds.size()
+                && value >= mThresholds[mBucket + 1] + mHysteresis;
+        if (!belowLow && !aboveHigh)
+            return;
+    }
+
+    const int bucket = lookup(value);
+    if (bucket == mBucket)
+        return;
+
+    mBucket = bucket;
+    apply();
+}
+
+void TrayValueMap::apply()
+{
+    SharedIcon *icon = mIcons.value(mBucket);
+    if (!icon)
+        return;
+
+    if (!icon->themeName().isEmpty())
+        mSni->setIconByName(icon->themeName());
+    else
+        mSni->setIconByPixmaps(icon->pixmaps().pixmaps, icon->pixmaps().key);
+}